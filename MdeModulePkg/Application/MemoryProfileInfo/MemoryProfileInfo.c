@@ -482,6 +482,34 @@ DumpMemoryProfileMemoryRange (
   return (VOID *) Descriptor;
 }
 
+/**
+  Dump memory profile pool cache information.
+
+  @param[in] PoolCache          Pointer to memory profile pool cache.
+
+  @return Pointer to the end of memory profile pool cache buffer.
+
+**/
+VOID *
+DumpMemoryProfilePoolCache (
+  IN MEMORY_PROFILE_POOL_CACHE      *PoolCache
+  )
+{
+  if (PoolCache->Header.Signature != MEMORY_PROFILE_POOL_CACHE_SIGNATURE) {
+    return NULL;
+  }
+  Print (L"MEMORY_PROFILE_POOL_CACHE\n");
+  Print (L"  Signature                     - 0x%08x\n", PoolCache->Header.Signature);
+  Print (L"  Length                        - 0x%04x\n", PoolCache->Header.Length);
+  Print (L"  Revision                      - 0x%04x\n", PoolCache->Header.Revision);
+  Print (L"  HitCount                      - 0x%016lx\n", PoolCache->HitCount);
+  Print (L"  MissCount                     - 0x%016lx\n", PoolCache->MissCount);
+  Print (L"  WastedBytes                   - 0x%016lx\n", PoolCache->WastedBytes);
+  Print (L"  CachedBytes                   - 0x%016lx\n", PoolCache->CachedBytes);
+
+  return (VOID *) ((UINTN) PoolCache + PoolCache->Header.Length);
+}
+
 /**
   Scan memory profile by Signature.
 
@@ -533,6 +561,7 @@ DumpMemoryProfile (
   MEMORY_PROFILE_CONTEXT        *Context;
   MEMORY_PROFILE_FREE_MEMORY    *FreeMemory;
   MEMORY_PROFILE_MEMORY_RANGE   *MemoryRange;
+  MEMORY_PROFILE_POOL_CACHE     *PoolCache;
 
   Context = (MEMORY_PROFILE_CONTEXT *) ScanMemoryProfileBySignature (ProfileBuffer, ProfileSize, MEMORY_PROFILE_CONTEXT_SIGNATURE);
   if (Context != NULL) {
@@ -548,6 +577,11 @@ DumpMemoryProfile (
   if (MemoryRange != NULL) {
     DumpMemoryProfileMemoryRange (MemoryRange);
   }
+
+  PoolCache = (MEMORY_PROFILE_POOL_CACHE *) ScanMemoryProfileBySignature (ProfileBuffer, ProfileSize, MEMORY_PROFILE_POOL_CACHE_SIGNATURE);
+  if (PoolCache != NULL) {
+    DumpMemoryProfilePoolCache (PoolCache);
+  }
 }
 
 /**
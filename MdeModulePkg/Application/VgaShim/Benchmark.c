@@ -0,0 +1,350 @@
+/** @file
+
+  Copyright (c) 2016, Dawid Ciecierski
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#include "Benchmark.h"
+#include "VgaShim.h"
+#include "Display.h"
+#include "Filesystem.h"
+#include "Util.h"
+
+
+/**
+  -----------------------------------------------------------------------------
+  Local method signatures.
+  -----------------------------------------------------------------------------
+**/
+
+VOID
+RecordIteration(
+	IN OUT	BENCHMARK_RESULT	*Result,
+	IN		UINT64				StartTimestamp);
+
+VOID
+BenchmarkLogoDecode(
+	IN		CONST VOID			*LogoSection,
+	OUT		BENCHMARK_RESULT	*Result,
+	OUT		IMAGE				**Image);
+
+VOID
+BenchmarkVesaInformation(
+	OUT		BENCHMARK_RESULT	*Result);
+
+VOID
+BenchmarkBlit(
+	IN		IMAGE				*Image,
+	OUT		BENCHMARK_RESULT	*Result);
+
+VOID
+BenchmarkFileRead(
+	IN		CHAR16				*FilePath,
+	OUT		BENCHMARK_RESULT	*Result);
+
+VOID
+PrintResult(
+	IN		BENCHMARK_RESULT	*Result);
+
+
+/**
+  -----------------------------------------------------------------------------
+  Local method implementations.
+  -----------------------------------------------------------------------------
+**/
+
+/**
+  Adds the time elapsed since the given timestamp to the result.
+
+  @param[in,out] Result   Benchmark result to update.
+  @param[in] StartTimestamp Timestamp taken at the start of the iteration.
+
+**/
+VOID
+RecordIteration(
+	IN OUT	BENCHMARK_RESULT	*Result,
+	IN		UINT64				StartTimestamp)
+{
+	UINT64	ElapsedUs;
+
+	ElapsedUs = TimestampToMicroseconds(GetTimestamp() - StartTimestamp);
+	Result->TotalUs += ElapsedUs;
+	if (ElapsedUs > Result->MaxUs) {
+		Result->MaxUs = ElapsedUs;
+	}
+	Result->Iterations++;
+}
+
+
+/**
+  Decompresses and converts the embedded logo repeatedly.
+  Every decoded image has to be identical to the first one.
+
+  @param[in] LogoSection  GUID-defined section holding the logo.
+  @param[out] Result      Benchmark result.
+  @param[out] Image       The first decoded image, or NULL on failure.
+                          Has to be freed by the caller.
+
+**/
+VOID
+BenchmarkLogoDecode(
+	IN	CONST VOID			*LogoSection,
+	OUT	BENCHMARK_RESULT	*Result,
+	OUT	IMAGE				**Image)
+{
+	IMAGE	*Decoded;
+	UINT64	Start;
+	UINTN	i;
+
+	Result->Name = L"Logo decode";
+	Result->Passed = TRUE;
+	*Image = NULL;
+	for (i = 0; i < BENCHMARK_ITERATIONS; i++) {
+		Start = GetTimestamp();
+		if (EFI_ERROR(CompressedBmpToImage(LogoSection, (VOID **)&Decoded))) {
+			Result->Passed = FALSE;
+			return;
+		}
+		RecordIteration(Result, Start);
+
+		if (*Image == NULL) {
+			*Image = Decoded;
+			continue;
+		}
+		if (Decoded->Width != (*Image)->Width || Decoded->Height != (*Image)->Height
+			|| CompareMem(Decoded->PixelData, (*Image)->PixelData,
+				Decoded->Width * Decoded->Height * sizeof(EFI_UGA_PIXEL)) != 0) {
+			Result->Passed = FALSE;
+		}
+		DestroyImage(Decoded);
+	}
+}
+
+
+/**
+  Fills in VESA information repeatedly into a scratch buffer
+  instead of the VGA ROM area, so no memory has to be unlocked.
+  The general information block has to carry the VESA signature
+  and a terminated mode list.
+
+  @param[out] Result      Benchmark result.
+
+**/
+VOID
+BenchmarkVesaInformation(
+	OUT	BENCHMARK_RESULT	*Result)
+{
+	EFI_PHYSICAL_ADDRESS	Scratch;
+	EFI_PHYSICAL_ADDRESS	EndAddress;
+	VBE_INFO				*VbeInfo;
+	UINT16					*ModeList;
+	UINT64					Start;
+	UINTN					i;
+
+	Result->Name = L"VESA information";
+	Result->Passed = FALSE;
+	VbeInfo = (VBE_INFO *)AllocateZeroPool(BENCHMARK_SCRATCH_SIZE);
+	if (VbeInfo == NULL) {
+		return;
+	}
+	Scratch = (EFI_PHYSICAL_ADDRESS)(UINTN)VbeInfo;
+
+	for (i = 0; i < BENCHMARK_ITERATIONS; i++) {
+		Start = GetTimestamp();
+		if (EFI_ERROR(ShimVesaInformation(Scratch, &EndAddress))) {
+			goto Exit;
+		}
+		RecordIteration(Result, Start);
+	}
+
+	// Only the low 16 bits of the mode list address are meaningful here.
+	ModeList = (UINT16 *)(VbeInfo->Buffer
+		+ (UINT16)((UINT16)VbeInfo->Base.ModeListAddress - (UINT16)(UINTN)VbeInfo->Buffer));
+	if (CompareMem(VbeInfo->Base.Signature, "VESA", 4) != 0
+		|| (UINT8 *)ModeList < VbeInfo->Buffer
+		|| (UINT8 *)ModeList >= (UINT8 *)(VbeInfo + 1)) {
+		goto Exit;
+	}
+	for (i = 0; i <= MAX_VESA_MODES; i++) {
+		if (ModeList[i] == 0xFFFF) {
+			Result->Passed = (i > 0);
+			break;
+		}
+	}
+
+Exit:
+	FreePool(VbeInfo);
+}
+
+
+/**
+  Draws the image in the middle of the screen repeatedly,
+  using whichever path DrawImage picks for it.
+
+  @param[in] Image        Image to draw.
+  @param[out] Result      Benchmark result.
+
+**/
+VOID
+BenchmarkBlit(
+	IN	IMAGE				*Image,
+	OUT	BENCHMARK_RESULT	*Result)
+{
+	UINT64	Start;
+	UINTN	i;
+
+	Result->Passed = TRUE;
+	for (i = 0; i < BENCHMARK_ITERATIONS; i++) {
+		Start = GetTimestamp();
+		DrawImageCentered(Image);
+		RecordIteration(Result, Start);
+	}
+}
+
+
+/**
+  Reads the given file repeatedly. Every read has to return
+  the same contents as the first one.
+
+  @param[in] FilePath     Path of the file to read.
+  @param[out] Result      Benchmark result.
+
+**/
+VOID
+BenchmarkFileRead(
+	IN	CHAR16				*FilePath,
+	OUT	BENCHMARK_RESULT	*Result)
+{
+	VOID	*First;
+	UINTN	FirstBytes;
+	VOID	*Contents;
+	UINTN	Bytes;
+	UINT64	Start;
+	UINTN	i;
+
+	Result->Name = L"File read";
+	Result->Passed = TRUE;
+	First = NULL;
+	FirstBytes = 0;
+	for (i = 0; i < BENCHMARK_ITERATIONS; i++) {
+		Start = GetTimestamp();
+		if (EFI_ERROR(FileRead(FilePath, &Contents, &Bytes))) {
+			Result->Passed = FALSE;
+			break;
+		}
+		RecordIteration(Result, Start);
+
+		if (First == NULL) {
+			First = Contents;
+			FirstBytes = Bytes;
+			continue;
+		}
+		if (Bytes != FirstBytes || CompareMem(Contents, First, Bytes) != 0) {
+			Result->Passed = FALSE;
+		}
+		FreePool(Contents);
+	}
+	if (First != NULL) {
+		FreePool(First);
+	}
+}
+
+
+/**
+  Prints a single benchmark result on the debug console.
+
+  @param[in] Result       Benchmark result.
+
+**/
+VOID
+PrintResult(
+	IN	BENCHMARK_RESULT	*Result)
+{
+	if (Result->Iterations == 0) {
+		PrintDebug(L"%-20s FAILED (no iterations completed)\n", Result->Name);
+		return;
+	}
+	PrintDebug(L"%-20s %s %u runs, avg %lu us, max %lu us\n",
+		Result->Name, Result->Passed ? L"ok    " : L"FAILED",
+		Result->Iterations, DivU64x32(Result->TotalUs, (UINT32)Result->Iterations), Result->MaxUs);
+}
+
+
+/**
+  -----------------------------------------------------------------------------
+  Exported method implementations.
+  -----------------------------------------------------------------------------
+**/
+
+/**
+  Times the performance-sensitive parts of the shim and checks their
+  results for consistency: decoding the embedded logo, generating VESA
+  information, drawing through Blt and straight into the framebuffer,
+  and reading the shim's own file. Nothing is written to the VGA ROM
+  or IVT areas, so this can be run anywhere a GOP/UGA adapter and
+  a file system are available, eg. in the EmulatorPkg platform on
+  a Linux host. Results are printed once all benchmarks have run
+  so that debug output does not skew the timings.
+
+  @param[in] LogoSection  GUID-defined section holding the embedded logo.
+
+  @retval EFI_SUCCESS     All benchmarks ran and their results were consistent.
+  @retval EFI_ABORTED     Some benchmark failed or produced inconsistent results.
+
+**/
+EFI_STATUS
+RunBenchmarks(
+	IN	CONST VOID	*LogoSection)
+{
+	BENCHMARK_RESULT	Results[5];
+	IMAGE				*Image;
+	CHAR16				*MyFilePath;
+	BOOLEAN				Native;
+	UINTN				NumResults;
+	UINTN				i;
+	BOOLEAN				Passed;
+
+	ZeroMem(Results, sizeof Results);
+	NumResults = 0;
+
+	BenchmarkLogoDecode(LogoSection, &Results[NumResults++], &Image);
+	BenchmarkVesaInformation(&Results[NumResults++]);
+	if (Image != NULL) {
+		SwtichToGraphics(FALSE);
+		ClearScreen();
+
+		Native = Image->Native;
+		Image->Native = FALSE;
+		Results[NumResults].Name = L"Blit (Blt)";
+		BenchmarkBlit(Image, &Results[NumResults++]);
+
+		// UGA pixels already match the framebuffer layout for BGR modes.
+		if (CanDrawDirectly() && DisplayInfo.PixelFormat == PixelBlueGreenRedReserved8BitPerColor) {
+			Image->Native = TRUE;
+			Results[NumResults].Name = L"Blit (framebuffer)";
+			BenchmarkBlit(Image, &Results[NumResults++]);
+		}
+
+		Image->Native = Native;
+		DestroyImage(Image);
+	}
+	MyFilePath = PathCleanUpDirectories(ConvertDevicePathToText(VgaShimImageInfo->FilePath, FALSE, FALSE));
+	BenchmarkFileRead(MyFilePath, &Results[NumResults++]);
+	FreePool(MyFilePath);
+
+	DebugMode = TRUE;
+	Passed = TRUE;
+	for (i = 0; i < NumResults; i++) {
+		PrintResult(&Results[i]);
+		Passed = Passed && Results[i].Passed && Results[i].Iterations > 0;
+	}
+	return Passed ? EFI_SUCCESS : EFI_ABORTED;
+}
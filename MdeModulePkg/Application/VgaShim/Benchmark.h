@@ -0,0 +1,76 @@
+/** @file
+
+  Copyright (c) 2016, Dawid Ciecierski
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#ifndef __BENCHMARK_H__
+#define __BENCHMARK_H__
+
+
+/**
+  -----------------------------------------------------------------------------
+  Constants.
+  -----------------------------------------------------------------------------
+**/
+
+#define	BENCHMARK_ITERATIONS	20
+#define	BENCHMARK_SCRATCH_SIZE	0x10000
+
+
+
+/**
+  -----------------------------------------------------------------------------
+  Includes.
+  -----------------------------------------------------------------------------
+**/
+
+#include <Uefi.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/MemoryAllocationLib.h>
+
+
+/**
+  -----------------------------------------------------------------------------
+  Type definitions and enums.
+  -----------------------------------------------------------------------------
+**/
+
+typedef struct {
+	CONST CHAR16	*Name;
+	UINTN			Iterations;
+	UINT64			TotalUs;
+	UINT64			MaxUs;
+	BOOLEAN			Passed;
+} BENCHMARK_RESULT;
+
+
+/**
+  -----------------------------------------------------------------------------
+  Exported method signatures.
+  -----------------------------------------------------------------------------
+**/
+
+EFI_STATUS
+RunBenchmarks(
+	IN	CONST VOID	*LogoSection);
+
+
+/**
+  -----------------------------------------------------------------------------
+  Imported global variables.
+  -----------------------------------------------------------------------------
+**/
+
+extern	BOOLEAN						DebugMode;
+
+
+#endif
@@ -33,6 +33,66 @@ EFI_STATUS
 InitializeDisplay(
 	VOID);
 
+EFI_STATUS
+ValidateBmpHeader(
+	IN		BMP_HEADER	*BmpHeader,
+	OUT		UINTN		*LineSizeBytes);
+
+VOID
+ConvertBmpLine(
+	IN		UINT8			*Source,
+	OUT		EFI_UGA_PIXEL	*Target,
+	IN		UINTN			NumPixels);
+
+BOOLEAN
+IsSsse3Supported(
+	VOID);
+
+VOID
+ConvertImageToNative(
+	IN OUT	IMAGE			*Image);
+
+VOID
+DrawImageDirect(
+	IN		IMAGE			*Image,
+	IN		UINTN			DrawWidth,
+	IN		UINTN			DrawHeight,
+	IN		UINTN			ScreenX,
+	IN		UINTN			ScreenY,
+	IN		UINTN			SpriteX,
+	IN		UINTN			SpriteY);
+
+VOID
+DrawAnimationFrame(
+	IN		BMP_ANIMATION	*Animation,
+	IN		IMAGE			*Image);
+
+VOID
+FinishAnimation(
+	IN		BMP_ANIMATION	*Animation);
+
+VOID
+EFIAPI
+AnimationTimerHandler(
+	IN		EFI_EVENT		Event,
+	IN		VOID			*Context);
+
+#if defined (MDE_CPU_X64)
+UINTN
+EFIAPI
+InternalConvertBgr24ToBgra32Ssse3(
+	OUT		VOID			*Target,
+	IN		VOID			*Source,
+	IN		UINTN			NumPixels);
+
+VOID
+EFIAPI
+InternalCopyPixelsNonTemporal(
+	OUT		VOID			*Target,
+	IN		VOID			*Source,
+	IN		UINTN			NumPixels);
+#endif
+
 
 /**
   -----------------------------------------------------------------------------
@@ -176,6 +236,309 @@ CalculatePositionForCenter(
 }
 
 
+/**
+  Checks that a bitmap header describes an image that can be
+  handled by the decoding routines and calculates the size of
+  a single line of pixel data in the file.
+
+  @param[in] BmpHeader     Pointer to the bitmap file header.
+  @param[out] LineSizeBytes Number of bytes taken by a single line
+                           of pixel data, including padding.
+
+  @retval EFI_SUCCESS      Header describes a supported image.
+  @retval other            Image format is not supported.
+
+**/
+EFI_STATUS
+ValidateBmpHeader(
+	IN	BMP_HEADER	*BmpHeader,
+	OUT	UINTN		*LineSizeBytes)
+{
+	if (BmpHeader->Signature[0] != 'B' 
+		|| BmpHeader->Signature[1] != 'M'
+		|| BmpHeader->CompressionType != 0	// only support uncompressed...
+		|| BmpHeader->BitPerPixel != 24		// ...24 bits per pixel images
+		|| BmpHeader->Width < 1
+		|| BmpHeader->Height < 1) {
+		return EFI_INVALID_PARAMETER;
+	}
+
+	// Calculate line size and adjust with padding to multiple of 4 bytes.
+	*LineSizeBytes = BmpHeader->Width * 3; // 24 bits = 3 bytes
+	*LineSizeBytes += (*LineSizeBytes % 4) != 0
+		? (4 - (*LineSizeBytes % 4))
+		: 0;
+
+	return EFI_SUCCESS;
+}
+
+
+/**
+  Checks once whether the processor supports SSSE3 instructions
+  (needed for the shuffle-based pixel conversion) and caches
+  the answer for subsequent calls.
+
+  @retval TRUE            SSSE3 instructions can be used.
+  @retval FALSE           SSSE3 instructions are not available.
+
+**/
+BOOLEAN
+IsSsse3Supported()
+{
+	STATIC BOOLEAN	Checked = FALSE;
+	STATIC BOOLEAN	Supported = FALSE;
+	UINT32			RegEcx;
+
+	if (!Checked) {
+		AsmCpuid(1, NULL, NULL, &RegEcx, NULL);
+		Supported = (RegEcx & BIT9) != 0;
+		Checked = TRUE;
+	}
+	return Supported;
+}
+
+
+/**
+  Converts a single line of 24bpp bitmap pixels into
+  in-memory pixel representation.
+
+  On X64 the bulk of the line is converted by an SSSE3 shuffle
+  kernel when available. Otherwise, and for the remaining pixels,
+  four pixels at a time are assembled from three 32-bit reads,
+  with single pixels handled at the end of the line.
+
+  @param[in] Source       First byte of pixel data in the bmp line.
+  @param[out] Target      First pixel of the destination line.
+  @param[in] NumPixels    Number of pixels to convert.
+
+**/
+VOID
+ConvertBmpLine(
+	IN	UINT8			*Source,
+	OUT	EFI_UGA_PIXEL	*Target,
+	IN	UINTN			NumPixels)
+{
+	UINT32	*Target32;
+	UINT32	Word0;
+	UINT32	Word1;
+	UINT32	Word2;
+	UINTN	x = 0;
+
+#if defined (MDE_CPU_X64)
+	if (IsSsse3Supported()) {
+		x = InternalConvertBgr24ToBgra32Ssse3(Target, Source, NumPixels);
+		Source += x * 3;
+		Target += x;
+	}
+#endif
+
+	// Memory layout of BGR pixels 0..3 in three little-endian words:
+	// B0 G0 R0 B1 | G1 R1 B2 G2 | R2 B3 G3 R3
+	Target32 = (UINT32 *)Target;
+	for (; x + 4 <= NumPixels; x += 4) {
+		Word0 = ReadUnaligned32((UINT32 *)Source);
+		Word1 = ReadUnaligned32((UINT32 *)(Source + 4));
+		Word2 = ReadUnaligned32((UINT32 *)(Source + 8));
+		Target32[0] = Word0 & 0x00ffffff;
+		Target32[1] = (Word0 >> 24) | ((Word1 & 0x0000ffff) << 8);
+		Target32[2] = (Word1 >> 16) | ((Word2 & 0x000000ff) << 16);
+		Target32[3] = Word2 >> 8;
+		Source += 12;
+		Target32 += 4;
+	}
+
+	Target = (EFI_UGA_PIXEL *)Target32;
+	for (; x < NumPixels; x++) {
+		Target->Blue		= *Source++;
+		Target->Green		= *Source++;
+		Target->Red			= *Source++;
+		Target->Reserved	= 0;
+		Target++;
+	}
+}
+
+
+/**
+  Rearranges pixels of an in-memory image into the pixel format
+  of the current video mode so that the image can be copied
+  straight into the framebuffer. Must only be called when
+  CanDrawDirectly returns TRUE.
+
+  @param[in,out] Image    Image whose pixels are to be converted.
+
+**/
+VOID
+ConvertImageToNative(
+	IN OUT	IMAGE	*Image)
+{
+	EFI_UGA_PIXEL	*Pixel;
+	EFI_UGA_PIXEL	*LastPixel;
+	UINT8			Temp;
+
+	if (DisplayInfo.PixelFormat == PixelRedGreenBlueReserved8BitPerColor) {
+		LastPixel = Image->PixelData + Image->Width * Image->Height;
+		for (Pixel = Image->PixelData; Pixel < LastPixel; Pixel++) {
+			Temp = Pixel->Blue;
+			Pixel->Blue = Pixel->Red;
+			Pixel->Red = Temp;
+		}
+	}
+	// PixelBlueGreenRedReserved8BitPerColor matches EFI_UGA_PIXEL.
+	Image->Native = TRUE;
+}
+
+
+/**
+  Copies a rectangle of an image already in framebuffer pixel
+  format straight into video memory, bypassing GOP->Blt. Lines
+  are written with non-temporal stores where available.
+  Bounds are expected to have been checked by the caller.
+
+  @param[in] Image        Image in framebuffer pixel format.
+  @param[in] DrawWidth    Width of the rectangle to copy.
+  @param[in] DrawHeight   Height of the rectangle to copy.
+  @param[in] ScreenX      Screen X coordinate of the top left corner.
+  @param[in] ScreenY      Screen Y coordinate of the top left corner.
+  @param[in] SpriteX      Image X coordinate of the top left corner.
+  @param[in] SpriteY      Image Y coordinate of the top left corner.
+
+**/
+VOID
+DrawImageDirect(
+	IN	IMAGE	*Image,
+	IN	UINTN	DrawWidth,
+	IN	UINTN	DrawHeight,
+	IN	UINTN	ScreenX,
+	IN	UINTN	ScreenY,
+	IN	UINTN	SpriteX,
+	IN	UINTN	SpriteY)
+{
+	UINT32	*Target;
+	UINT32	*Source;
+	UINTN	y;
+
+	Target = (UINT32 *)(UINTN)DisplayInfo.FrameBufferBase
+		+ ScreenY * DisplayInfo.PixelsPerScanLine + ScreenX;
+	Source = (UINT32 *)Image->PixelData + SpriteY * Image->Width + SpriteX;
+
+	for (y = 0; y < DrawHeight; y++) {
+#if defined (MDE_CPU_X64)
+		InternalCopyPixelsNonTemporal(Target, Source, DrawWidth);
+#else
+		CopyMem(Target, Source, DrawWidth * sizeof(UINT32));
+#endif
+		Target += DisplayInfo.PixelsPerScanLine;
+		Source += Image->Width;
+	}
+}
+
+
+/**
+  Draws a decoded animation frame in its place on screen and
+  records how long drawing took.
+
+  @param[in] Animation    Animation the frame belongs to.
+  @param[in] Image        Decoded frame.
+
+**/
+VOID
+DrawAnimationFrame(
+	IN	BMP_ANIMATION	*Animation,
+	IN	IMAGE			*Image)
+{
+	UINT64	DrawStart;
+	UINT64	DrawTicks;
+
+	DrawStart = GetTimestamp();
+	DrawImage(Image, Image->Width, Image->Height, Animation->PositionX, Animation->PositionY, 0, 0);
+	DrawTicks = GetTimestamp() - DrawStart;
+
+	Animation->FramesDrawn++;
+	Animation->DrawTicksTotal += DrawTicks;
+	if (DrawTicks > Animation->DrawTicksMax) {
+		Animation->DrawTicksMax = DrawTicks;
+	}
+}
+
+
+/**
+  Stops the playback timer and wakes up anyone waiting for
+  the animation to end.
+
+  @param[in] Animation    Animation that has ended.
+
+**/
+VOID
+FinishAnimation(
+	IN	BMP_ANIMATION	*Animation)
+{
+	Animation->Playing = FALSE;
+	gBS->SetTimer(Animation->Timer, TimerCancel, 0);
+	gBS->SignalEvent(Animation->Finished);
+}
+
+
+/**
+  Periodic timer notification that keeps the animation on
+  schedule. Works out which frame should be on screen by now,
+  skipping any frames whose time has already passed, draws it
+  and decodes the next one ahead of its due time.
+
+  @param[in] Event        Playback timer event.
+  @param[in] Context      Animation being played.
+
+**/
+VOID
+EFIAPI
+AnimationTimerHandler(
+	IN	EFI_EVENT	Event,
+	IN	VOID		*Context)
+{
+	BMP_ANIMATION	*Animation;
+	EFI_STATUS		Status;
+	IMAGE			*Image;
+	UINT64			ElapsedUs;
+	UINTN			Due;
+
+	Animation = (BMP_ANIMATION *)Context;
+	if (!Animation->Playing) {
+		return;
+	}
+
+	ElapsedUs = TimestampToMicroseconds(GetTimestamp() - Animation->StartTimestamp);
+	Due = (UINTN)DivU64x32(ElapsedUs, (UINT32)(Animation->MsPerFrame * 1000));
+	if (Due < Animation->NextFrame) {
+		return;
+	}
+	if (Due >= Animation->NumFrames) {
+		// Running late at the very end; still show the last frame.
+		Due = Animation->NumFrames - 1;
+	}
+
+	if (Due == Animation->PendingFrame) {
+		Image = Animation->Pending;
+	} else {
+		Status = BmpAnimationReadFrame(Animation, Due, &Image);
+		if (EFI_ERROR(Status)) {
+			FinishAnimation(Animation);
+			return;
+		}
+	}
+
+	Animation->FramesDropped += Due - Animation->NextFrame;
+	DrawAnimationFrame(Animation, Image);
+	Animation->NextFrame = Due + 1;
+	if (Animation->NextFrame >= Animation->NumFrames) {
+		FinishAnimation(Animation);
+		return;
+	}
+
+	// Decode the next frame now so that it is ready when due.
+	Status = BmpAnimationReadFrame(Animation, Animation->NextFrame, &Animation->Pending);
+	Animation->PendingFrame = EFI_ERROR(Status) ? Animation->NumFrames : Animation->NextFrame;
+}
+
+
 /**
   -----------------------------------------------------------------------------
   Exported method implementations.
@@ -200,12 +563,40 @@ EFI_STATUS
 EnsureDisplayAvailable()
 {
 	if (!DisplayInfo.Initialized) {
+		TimingStart("Display");
 		InitializeDisplay();
+		TimingEnd("Display");
 	}
 	return DisplayInfo.AdapterFound && DisplayInfo.Protocol != NONE ? EFI_SUCCESS : EFI_NOT_FOUND;
 }
 
 
+/**
+  Checks whether images can be copied straight into the linear
+  framebuffer of the current video mode instead of going through
+  GOP->Blt. This requires a GOP adapter exposing its framebuffer
+  in one of the 32 bits per pixel formats.
+
+  @retval TRUE            Framebuffer can be written to directly.
+  @retval FALSE           Blt has to be used for drawing.
+
+**/
+BOOLEAN
+CanDrawDirectly()
+{
+	if (EFI_ERROR(EnsureDisplayAvailable())) {
+		return FALSE;
+	}
+
+	// PixelBltOnly has no linear framebuffer and PixelBitMask
+	// would need per-pixel repacking, so leave them to Blt.
+	return DisplayInfo.Protocol == GOP
+		&& DisplayInfo.FrameBufferBase != 0
+		&& (DisplayInfo.PixelFormat == PixelBlueGreenRedReserved8BitPerColor
+			|| DisplayInfo.PixelFormat == PixelRedGreenBlueReserved8BitPerColor);
+}
+
+
 /**
   Prints important information about the currently running video
   mode. Initializes adapters if they have not yet been detected.
@@ -272,6 +663,7 @@ CreateImage(
 		
 	Image->Width = Width;
 	Image->Height = Height;
+	Image->Native = FALSE;
 	Image->PixelData = (EFI_UGA_PIXEL *)AllocatePool(Width * Height * sizeof(EFI_UGA_PIXEL));
 	if (Image->PixelData == NULL) {
 		DestroyImage(Image);
@@ -331,11 +723,10 @@ BmpFileToImage(
 {
 	//IMAGE			*Image;
 	BMP_HEADER		*BmpHeader;
-	UINT8			*BmpCurrentPixel;
 	UINT8			*BmpCurrentLine;
 	UINTN			LineSizeBytes;
-	EFI_UGA_PIXEL	*TargetPixel;
-	UINTN			x, y;
+	EFI_UGA_PIXEL	*TargetLine;
+	UINTN			y;
 
 	// Sanity checks.
 	if (FileData == NULL || FileSizeBytes < sizeof(BMP_HEADER)) {
@@ -344,12 +735,7 @@ BmpFileToImage(
 	}
 
 	BmpHeader = (BMP_HEADER *)FileData;
-	if (BmpHeader->Signature[0] != 'B' 
-		|| BmpHeader->Signature[1] != 'M'
-		|| BmpHeader->CompressionType != 0	// only support uncompressed...
-		|| BmpHeader->BitPerPixel != 24		// ...24 bits per pixel images
-		|| BmpHeader->Width < 1
-		|| BmpHeader->Height < 1) {
+	if (EFI_ERROR(ValidateBmpHeader(BmpHeader, &LineSizeBytes))) {
 		return EFI_INVALID_PARAMETER;
 	}
 		
@@ -360,12 +746,6 @@ BmpFileToImage(
 		return EFI_OUT_OF_RESOURCES;
 	}
 	
-	// Calculate line size and adjust with padding to multiple of 4 bytes.
-	LineSizeBytes = BmpHeader->Width * 3; // 24 bits = 3 bytes
-	LineSizeBytes += (LineSizeBytes % 4) != 0
-		? (4 - (LineSizeBytes % 4))
-		: 0;
-	
 	// Check if we have enough pixel data.
 	if (BmpHeader->PixelDataOffset + BmpHeader->Height * LineSizeBytes > FileSizeBytes) {
 		PrintDebug(L"Not enough pixel data (%u bytes, expected %u)\n", 
@@ -377,18 +757,11 @@ BmpFileToImage(
 	// Fill in pixel values.
 	BmpCurrentLine = FileData + BmpHeader->PixelDataOffset;
 	for (y = 0; y < BmpHeader->Height; y++) {
-		BmpCurrentPixel = BmpCurrentLine;
-		BmpCurrentLine += LineSizeBytes;
 		// jump to the right pixel line; BMP PixelArray is bottom-to-top...
-		TargetPixel = ((IMAGE *)*Result)->PixelData + BmpHeader->Width * (BmpHeader->Height - y - 1);
+		TargetLine = ((IMAGE *)*Result)->PixelData + BmpHeader->Width * (BmpHeader->Height - y - 1);
 		// ...but thankfully left-to-right
-		for (x = 0; x < BmpHeader->Width; x++) {
-			TargetPixel->Blue		= *BmpCurrentPixel++;
-			TargetPixel->Green		= *BmpCurrentPixel++;
-			TargetPixel->Red		= *BmpCurrentPixel++;
-			TargetPixel->Reserved	= 0;
-			TargetPixel++;
-		}
+		ConvertBmpLine(BmpCurrentLine, TargetLine, BmpHeader->Width);
+		BmpCurrentLine += LineSizeBytes;
 	}
 
 	PrintDebug(L"Successfully imported image size %ux%u from bmp file\n", 
@@ -397,6 +770,293 @@ BmpFileToImage(
 }
 
 
+/**
+  Converts a compressed bitmap file embedded in the binary into
+  a memory representation useful for other graphics in-memory
+  operations. The bitmap has to be wrapped in a GUID-defined
+  section as generated by EmbedImage.sh; decompression is left
+  to whichever handler is registered for the section GUID
+  (normally LzmaCustomDecompressLib).
+
+  Any error messages will only be printed on the debug console
+  and only the error code returned to caller.
+
+  @param[in] Section       Pointer to the GUID-defined section
+                           holding the compressed bitmap file.
+  @param[out] Result       Pointer to a mermory location holding
+                           the address of the image structure
+                           and data representing the bitmap.
+
+  @retval EFI_SUCCESS      Section was decompressed and its contents
+                           interpreted successfully.
+  @retval other            Either the section could not be decompressed,
+                           it contained no valid or supported image
+                           or no memory could be allocated.
+
+**/
+EFI_STATUS
+CompressedBmpToImage(
+	IN	CONST VOID	*Section,
+	OUT	VOID		**Result)
+{
+	EFI_STATUS		Status;
+	UINT32			FileSizeBytes;
+	UINT32			ScratchSizeBytes;
+	UINT16			SectionAttributes;
+	UINT32			AuthenticationStatus;
+	VOID			*FileBuffer;
+	VOID			*FileData;
+	VOID			*Scratch;
+
+	FileBuffer = NULL;
+	Scratch = NULL;
+
+	Status = ExtractGuidedSectionGetInfo(Section, &FileSizeBytes, &ScratchSizeBytes, &SectionAttributes);
+	if (EFI_ERROR(Status)) {
+		PrintDebug(L"Unable to get information about compressed image (%r)\n", Status);
+		goto Exit;
+	}
+
+	FileBuffer = AllocatePool(FileSizeBytes);
+	Scratch = AllocatePool(ScratchSizeBytes);
+	if (FileBuffer == NULL || Scratch == NULL) {
+		PrintDebug(L"Unable to allocate %u bytes to decompress image\n", FileSizeBytes + ScratchSizeBytes);
+		Status = EFI_OUT_OF_RESOURCES;
+		goto Exit;
+	}
+
+	// Decoding may leave FileData pointing into the section itself.
+	FileData = FileBuffer;
+	Status = ExtractGuidedSectionDecode(Section, &FileData, Scratch, &AuthenticationStatus);
+	if (EFI_ERROR(Status)) {
+		PrintDebug(L"Unable to decompress image (%r)\n", Status);
+		goto Exit;
+	}
+
+	Status = BmpFileToImage((UINT8 *)FileData, FileSizeBytes, Result);
+
+Exit:
+	if (Scratch != NULL) {
+		FreePool(Scratch);
+	}
+	if (FileBuffer != NULL) {
+		FreePool(FileBuffer);
+	}
+	return Status;
+}
+
+
+/**
+  Prepares an animated bitmap file for frame-at-a-time decoding.
+  Only the header is read; pixel data of each frame is read
+  and converted on demand by BmpAnimationReadFrame, so memory
+  use is bounded by the size of a single frame rather than
+  by the length of the animation.
+
+  The image is split into square frames whose side is equal
+  to the shorter side of the image. Frames are stacked either
+  top-to-bottom or left-to-right.
+
+  @param[in] File          Handle of a file opened for reading.
+                           Ownership passes to the animation and
+                           the file is closed by BmpAnimationClose.
+  @param[out] Animation    Pointer to a memory location receiving
+                           the address of the animation structure.
+
+  @retval EFI_SUCCESS      Header was read and all buffers allocated.
+  @retval other            Either the file contained no valid or 
+                           supported image, no memory could be
+                           allocated to hold a frame or some other
+                           problem was encountered.
+
+**/
+EFI_STATUS
+BmpAnimationOpen(
+	IN	EFI_FILE_HANDLE	File,
+	OUT	BMP_ANIMATION	**Animation)
+{
+	EFI_STATUS		Status;
+	BMP_ANIMATION	*Anim;
+	UINTN			Size;
+
+	*Animation = NULL;
+	Anim = (BMP_ANIMATION *)AllocateZeroPool(sizeof(BMP_ANIMATION));
+	if (Anim == NULL) {
+		return EFI_OUT_OF_RESOURCES;
+	}
+	Anim->File = File;
+
+	// Read and check the header.
+	Size = sizeof(BMP_HEADER);
+	Status = File->SetPosition(File, 0);
+	if (!EFI_ERROR(Status)) {
+		Status = File->Read(File, &Size, &Anim->Header);
+	}
+	if (EFI_ERROR(Status) || Size != sizeof(BMP_HEADER)) {
+		PrintDebug(L"Unable to read bmp header (error: %r)\n", Status);
+		Status = EFI_INVALID_PARAMETER;
+		goto Exit;
+	}
+	Status = ValidateBmpHeader(&Anim->Header, &Anim->LineSizeBytes);
+	if (EFI_ERROR(Status)) {
+		PrintDebug(L"Unsupported bmp file\n");
+		goto Exit;
+	}
+
+	// Work out frame layout.
+	Anim->Horizontal = Anim->Header.Width > Anim->Header.Height;
+	Anim->FrameSide = Anim->Horizontal ? Anim->Header.Height : Anim->Header.Width;
+	Anim->NumFrames = Anim->Horizontal
+		? Anim->Header.Width / Anim->FrameSide
+		: Anim->Header.Height / Anim->FrameSide;
+	Anim->StripLineBytes = Anim->Horizontal
+		? Anim->FrameSide * 3
+		: Anim->LineSizeBytes;
+
+	// Allocate the raw strip and both decoded frame buffers.
+	Anim->Strip = (UINT8 *)AllocatePool(Anim->StripLineBytes * Anim->FrameSide);
+	Anim->Frames[0] = CreateImage(Anim->FrameSide, Anim->FrameSide);
+	Anim->Frames[1] = CreateImage(Anim->FrameSide, Anim->FrameSide);
+	if (Anim->Strip == NULL || Anim->Frames[0] == NULL || Anim->Frames[1] == NULL) {
+		PrintDebug(L"Unable to allocate enough memory for frame size %ux%u\n", 
+			Anim->FrameSide, Anim->FrameSide);
+		Status = EFI_OUT_OF_RESOURCES;
+		goto Exit;
+	}
+
+	PrintDebug(L"Prepared animation of %u frames size %ux%u from bmp file\n", 
+		Anim->NumFrames, Anim->FrameSide, Anim->FrameSide);
+
+Exit:
+	if (EFI_ERROR(Status)) {
+		// Leave the file open for the caller in case of failure.
+		Anim->File = NULL;
+		BmpAnimationClose(Anim);
+	} else {
+		*Animation = Anim;
+	}
+	return Status;
+}
+
+
+/**
+  Reads pixel data of a single frame off the disk and converts
+  it into a frame-sized image. Subsequent calls alternate between
+  two decoded frame buffers so that the previously returned frame
+  remains valid while the next one is being prepared.
+
+  @param[in] Animation     Animation prepared with BmpAnimationOpen.
+  @param[in] Frame         Zero-based index of the frame to decode.
+  @param[out] Image        Pointer to a memory location receiving
+                           the address of the decoded frame. Owned
+                           by the animation; do not destroy.
+
+  @retval EFI_SUCCESS      Frame was decoded successfully.
+  @retval other            Frame index out of range or file
+                           could not be read.
+
+**/
+EFI_STATUS
+BmpAnimationReadFrame(
+	IN	BMP_ANIMATION	*Animation,
+	IN	UINTN			Frame,
+	OUT	IMAGE			**Image)
+{
+	EFI_STATUS		Status;
+	EFI_FILE_HANDLE	File;
+	IMAGE			*Target;
+	UINT64			Position;
+	UINTN			Size;
+	UINTN			Side;
+	UINTN			y;
+
+	if (Animation == NULL || Frame >= Animation->NumFrames) {
+		return EFI_INVALID_PARAMETER;
+	}
+
+	File = Animation->File;
+	Side = Animation->FrameSide;
+
+	if (Animation->Horizontal) {
+		// Every bmp line holds a slice of every frame, so the frame
+		// has to be gathered one line at a time.
+		for (y = 0; y < Side; y++) {
+			Position = Animation->Header.PixelDataOffset
+				+ y * Animation->LineSizeBytes
+				+ Frame * Side * 3;
+			Size = Animation->StripLineBytes;
+			Status = File->SetPosition(File, Position);
+			if (!EFI_ERROR(Status)) {
+				Status = File->Read(File, &Size, Animation->Strip + y * Animation->StripLineBytes);
+			}
+			if (EFI_ERROR(Status) || Size != Animation->StripLineBytes) {
+				PrintDebug(L"Unable to read frame %u (error: %r)\n", Frame, Status);
+				return EFI_DEVICE_ERROR;
+			}
+		}
+	} else {
+		// Top frame is stored last as bmp lines are bottom-to-top,
+		// but all lines of a frame are contiguous in the file.
+		Position = Animation->Header.PixelDataOffset
+			+ (Animation->Header.Height - (Frame + 1) * Side) * Animation->LineSizeBytes;
+		Size = Side * Animation->StripLineBytes;
+		Status = File->SetPosition(File, Position);
+		if (!EFI_ERROR(Status)) {
+			Status = File->Read(File, &Size, Animation->Strip);
+		}
+		if (EFI_ERROR(Status) || Size != Side * Animation->StripLineBytes) {
+			PrintDebug(L"Unable to read frame %u (error: %r)\n", Frame, Status);
+			return EFI_DEVICE_ERROR;
+		}
+	}
+
+	// Convert into the buffer not holding the previous frame.
+	Animation->CurrentFrame ^= 1;
+	Target = Animation->Frames[Animation->CurrentFrame];
+	for (y = 0; y < Side; y++) {
+		ConvertBmpLine(
+			Animation->Strip + y * Animation->StripLineBytes,
+			Target->PixelData + Side * (Side - y - 1),
+			Side);
+	}
+	if (CanDrawDirectly()) {
+		ConvertImageToNative(Target);
+	}
+
+	*Image = Target;
+	return EFI_SUCCESS;
+}
+
+
+/**
+  Releases all resources held by the specified animation,
+  including the underlying file handle. Playback is stopped
+  if still in progress.
+
+  @param[in] Animation    Animation whose resources are to
+                          be released.
+
+**/
+VOID
+BmpAnimationClose(
+	IN	BMP_ANIMATION	*Animation)
+{
+	if (Animation == NULL) {
+		return;
+	}
+	BmpAnimationStop(Animation);
+	if (Animation->File != NULL) {
+		Animation->File->Close(Animation->File);
+	}
+	if (Animation->Strip != NULL) {
+		FreePool(Animation->Strip);
+	}
+	DestroyImage(Animation->Frames[0]);
+	DestroyImage(Animation->Frames[1]);
+	FreePool(Animation);
+}
+
+
 /**
   Clears screen in both text and graphics modes.
 
@@ -463,7 +1123,9 @@ DrawImage(
 
 	SwtichToGraphics(FALSE);
 
-	if (DisplayInfo.Protocol == GOP) {
+	if (Image->Native) {
+		DrawImageDirect(Image, DrawWidth, DrawHeight, ScreenX, ScreenY, SpriteX, SpriteY);
+	} else if (DisplayInfo.Protocol == GOP) {
 		DisplayInfo.GOP->Blt(DisplayInfo.GOP, 
 			(EFI_GRAPHICS_OUTPUT_BLT_PIXEL *)Image->PixelData, 
 			EfiBltBufferToVideo, 
@@ -541,6 +1203,134 @@ AnimateImage(
 }
 
 
+/**
+  Starts playing an animation decoded frame-by-frame from a
+  bitmap file. The first frame is drawn before returning; the
+  remaining frames are drawn from a periodic timer event while
+  the caller carries on with other work. Frames are kept on
+  a fixed schedule and skipped when drawing falls behind it.
+
+  @param[in] Animation    Animation prepared with BmpAnimationOpen.
+  @param[in] MsPerFrame   Target time each frame stays on screen.
+
+  @retval EFI_SUCCESS     Playback has started.
+  @retval other           Animation could not be shown.
+
+**/
+EFI_STATUS
+BmpAnimationStart(
+	IN	BMP_ANIMATION	*Animation,
+	IN	UINTN			MsPerFrame)
+{
+	EFI_STATUS	Status;
+	IMAGE		*Image;
+
+	Status = CalculatePositionForCenter(Animation->FrameSide, Animation->FrameSide,
+		&Animation->PositionX, &Animation->PositionY);
+	if (EFI_ERROR(Status)) {
+		return Status;
+	}
+
+	// Calibrate the timestamp counter here rather than in the timer handler.
+	TimestampToMicroseconds(0);
+
+	Status = gBS->CreateEvent(0, 0, NULL, NULL, &Animation->Finished);
+	if (EFI_ERROR(Status)) {
+		return Status;
+	}
+	Status = gBS->CreateEvent(EVT_TIMER | EVT_NOTIFY_SIGNAL, TPL_CALLBACK,
+		AnimationTimerHandler, Animation, &Animation->Timer);
+	if (EFI_ERROR(Status)) {
+		PrintDebug(L"Unable to create animation timer (error: %r)\n", Status);
+		return Status;
+	}
+
+	// Show the first frame right away.
+	Status = BmpAnimationReadFrame(Animation, 0, &Image);
+	if (EFI_ERROR(Status)) {
+		return Status;
+	}
+	Animation->MsPerFrame = MsPerFrame;
+	Animation->StartTimestamp = GetTimestamp();
+	DrawAnimationFrame(Animation, Image);
+	Animation->NextFrame = 1;
+	Animation->PendingFrame = Animation->NumFrames;
+	Animation->Playing = TRUE;
+	if (Animation->NumFrames == 1) {
+		FinishAnimation(Animation);
+		return EFI_SUCCESS;
+	}
+
+	Status = BmpAnimationReadFrame(Animation, 1, &Animation->Pending);
+	if (!EFI_ERROR(Status)) {
+		Animation->PendingFrame = 1;
+	}
+
+	Status = gBS->SetTimer(Animation->Timer, TimerPeriodic, MsPerFrame * 10000);
+	if (EFI_ERROR(Status)) {
+		PrintDebug(L"Unable to start animation timer (error: %r)\n", Status);
+		FinishAnimation(Animation);
+	}
+	return EFI_SUCCESS;
+}
+
+
+/**
+  Blocks until the last frame of an animation started with
+  BmpAnimationStart has been drawn.
+
+  @param[in] Animation    Animation being played.
+
+**/
+VOID
+BmpAnimationWait(
+	IN	BMP_ANIMATION	*Animation)
+{
+	UINTN	Index;
+
+	if (Animation->Finished != NULL && Animation->Playing) {
+		gBS->WaitForEvent(1, &Animation->Finished, &Index);
+	}
+}
+
+
+/**
+  Stops playback of an animation, leaving whatever frame is
+  currently on screen, and reports drawing statistics.
+
+  @param[in] Animation    Animation being played.
+
+**/
+VOID
+BmpAnimationStop(
+	IN	BMP_ANIMATION	*Animation)
+{
+	EFI_TPL	OldTpl;
+
+	if (Animation->Timer != NULL) {
+		// Make sure the timer handler is not running meanwhile.
+		OldTpl = gBS->RaiseTPL(TPL_CALLBACK);
+		Animation->Playing = FALSE;
+		gBS->CloseEvent(Animation->Timer);
+		Animation->Timer = NULL;
+		gBS->RestoreTPL(OldTpl);
+	}
+	if (Animation->Finished != NULL) {
+		gBS->CloseEvent(Animation->Finished);
+		Animation->Finished = NULL;
+	}
+
+	if (Animation->FramesDrawn > 0) {
+		PrintDebug(L"Drew %u frames %s (%u dropped), average %lu us, max %lu us per frame\n",
+			Animation->FramesDrawn,
+			CanDrawDirectly() ? L"directly" : L"with Blt",
+			Animation->FramesDropped,
+			TimestampToMicroseconds(Animation->DrawTicksTotal) / Animation->FramesDrawn,
+			TimestampToMicroseconds(Animation->DrawTicksMax));
+	}
+}
+
+
 VOID
 SwitchToText(
 	IN	BOOLEAN	Force)
@@ -23,12 +23,15 @@
 **/
 
 #include <Uefi.h>
+#include <Library/BaseLib.h>
 #include <Library/BaseMemoryLib.h>
+#include <Library/ExtractGuidedSectionLib.h>
 #include <Library/MemoryAllocationLib.h>
 #include <Library/UefiBootServicesTableLib.h>
 #include <Library/UefiLib.h>
 #include <Protocol/GraphicsOutput.h>
 #include <Protocol/LoadedImage.h>
+#include <Protocol/SimpleFileSystem.h>
 #include <Protocol/UgaDraw.h>
 #include <Foundation/Protocol/ConsoleControl/ConsoleControl.h>
 
@@ -42,6 +45,7 @@
 typedef struct {
 	UINTN			Width;
 	UINTN			Height;
+	BOOLEAN			Native;		// pixels already in framebuffer format
 	EFI_UGA_PIXEL	*PixelData;
 } IMAGE;
 
@@ -90,6 +94,34 @@ typedef struct {
 } BMP_HEADER;
 #pragma pack()
 
+typedef struct {
+	EFI_FILE_HANDLE	File;
+	BMP_HEADER		Header;
+	UINTN			LineSizeBytes;		// bmp line size including padding
+	UINTN			FrameSide;			// frames are square
+	UINTN			NumFrames;
+	BOOLEAN			Horizontal;			// frames stacked left-to-right
+	UINT8			*Strip;				// raw bmp bytes of a single frame
+	UINTN			StripLineBytes;
+	IMAGE			*Frames[2];			// decoded frames, used alternately
+	UINTN			CurrentFrame;
+	UINTN			FramesDrawn;
+	UINTN			FramesDropped;
+	UINT64			DrawTicksTotal;
+	UINT64			DrawTicksMax;
+	// Playback scheduling.
+	EFI_EVENT		Timer;				// periodic, draws frames that are due
+	EFI_EVENT		Finished;			// signalled after the last frame
+	BOOLEAN			Playing;
+	UINT64			StartTimestamp;
+	UINTN			MsPerFrame;
+	UINTN			PositionX;
+	UINTN			PositionY;
+	UINTN			NextFrame;			// first frame not drawn yet
+	UINTN			PendingFrame;		// frame decoded ahead of time
+	IMAGE			*Pending;
+} BMP_ANIMATION;
+
 
 /**
   -----------------------------------------------------------------------------
@@ -127,6 +159,26 @@ BmpFileToImage(
 	IN	UINTN	FileSizeBytes,
 	OUT	VOID	**Result);
 
+EFI_STATUS
+CompressedBmpToImage(
+	IN	CONST VOID	*Section,
+	OUT	VOID		**Result);
+
+EFI_STATUS
+BmpAnimationOpen(
+	IN	EFI_FILE_HANDLE	File,
+	OUT	BMP_ANIMATION	**Animation);
+
+EFI_STATUS
+BmpAnimationReadFrame(
+	IN	BMP_ANIMATION	*Animation,
+	IN	UINTN			Frame,
+	OUT	IMAGE			**Image);
+
+VOID
+BmpAnimationClose(
+	IN	BMP_ANIMATION	*Animation);
+
 VOID
 DrawImage(
 	IN	IMAGE	*Image,
@@ -137,6 +189,10 @@ DrawImage(
 	IN	UINTN	ImageX,
 	IN	UINTN	ImageY);
 
+BOOLEAN
+CanDrawDirectly(
+	VOID);
+
 VOID
 DrawImageCentered(
 	IN	IMAGE	*Image);
@@ -145,6 +201,19 @@ VOID
 AnimateImage(
 	IN	IMAGE	*Image);
 
+EFI_STATUS
+BmpAnimationStart(
+	IN	BMP_ANIMATION	*Animation,
+	IN	UINTN			MsPerFrame);
+
+VOID
+BmpAnimationWait(
+	IN	BMP_ANIMATION	*Animation);
+
+VOID
+BmpAnimationStop(
+	IN	BMP_ANIMATION	*Animation);
+
 EFI_STATUS
 EnsureDisplayAvailable(
 	VOID);
@@ -0,0 +1,90 @@
+#!/bin/sh
+###
+# @file
+# Shell script to compress an image file with LZMA and dump it to a C array,
+# wrapped in a GUID-defined section that LzmaCustomDecompressLib can decode.
+#
+# Usage: EmbedImage.sh <image file> [array name]
+#
+# The array name defaults to the image file name sans extension; the output
+# is written next to this script as <array name>.h. LzmaCompress from the
+# EDK2 BaseTools has to be available in PATH.
+#
+# Copyright (c) 2016, Dawid Ciecierski
+#
+# This program and the accompanying materials are licensed and made available
+# under the terms and conditions of the BSD License which accompanies this
+# distribution.  The full text of the license may be found at
+# http://opensource.org/licenses/bsd-license.php
+#
+# THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS, WITHOUT
+# WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+#
+###
+
+set -e -u
+
+IMAGE=$1
+NAME=${2:-$(basename -- "$IMAGE" | sed -e 's,\.[^.]*$,,')}
+STEM=$(dirname -- "$0")/$NAME
+
+#
+# Install exit handler -- remove temporary files.
+#
+exit_handler()
+{
+  rm -f -- "$STEM".lzma "$STEM".section
+}
+trap exit_handler EXIT
+
+#
+# Compress the image.
+#
+LzmaCompress -e -o "$STEM".lzma "$IMAGE"
+
+#
+# Emit a single byte given as a decimal number.
+#
+byte()
+{
+  printf "\\$(printf '%03o' "$1")"
+}
+
+#
+# Prepend EFI_GUID_DEFINED_SECTION header (24 bytes):
+#   Size (3 bytes), Type = EFI_SECTION_GUID_DEFINED (0x02),
+#   SectionDefinitionGuid = gLzmaCustomDecompressGuid,
+#   DataOffset = 24, Attributes = EFI_GUIDED_SECTION_PROCESSING_REQUIRED.
+#
+SIZE=$(( $(wc -c <"$STEM".lzma) + 24 ))
+if [ $SIZE -gt 16777215 ]; then
+  echo "$IMAGE: compressed image too large" >&2
+  exit 1
+fi
+{
+  byte $(( SIZE & 0xff ))
+  byte $(( (SIZE >> 8) & 0xff ))
+  byte $(( (SIZE >> 16) & 0xff ))
+  byte 2
+  printf '\230\130\116\356\024\071\131\102\235\156\334\173\327\224\003\317'
+  byte 24
+  byte 0
+  byte 1
+  byte 0
+  cat -- "$STEM".lzma
+} >"$STEM".section
+
+#
+# Write the output file, ten bytes per line.
+#
+{
+  printf '//\n'
+  printf '// THIS FILE WAS GENERATED BY "%s" FROM "%s". DO NOT EDIT.\n' \
+      "$(basename -- "$0")" "$(basename -- "$IMAGE")"
+  printf '//\n'
+  printf 'STATIC CONST UINT8 %s[] = {\n' "$NAME"
+  od -A n -v -t x1 -w10 -- "$STEM".section \
+  | sed -e 's/ \([0-9a-f][0-9a-f]\)/ 0x\1,/g' \
+        -e 's/^ /\t/' -e 's/,$//' -e '$!s/$/,/'
+  printf '};\n'
+} >"$STEM".h
@@ -16,6 +16,74 @@
 #include "Util.h"
 
 
+/**
+  -----------------------------------------------------------------------------
+  Variables.
+  -----------------------------------------------------------------------------
+**/
+
+STATIC EFI_FILE_HANDLE	ShimVolumeRoot = NULL;
+
+
+/**
+  -----------------------------------------------------------------------------
+  Local method signatures.
+  -----------------------------------------------------------------------------
+**/
+
+EFI_STATUS
+GetVolumeRoot(
+	OUT	EFI_FILE_HANDLE	*VolumeRoot);
+
+
+/**
+  -----------------------------------------------------------------------------
+  Local method implementations.
+  -----------------------------------------------------------------------------
+**/
+
+/**
+  Provides the root of the volume where the VgaShim executable
+  is located. The volume is only opened on first use and kept
+  open until FileCloseVolume is called, so that probing and
+  reading several files does not reopen it every time.
+
+  @param[out] VolumeRoot  Pointer to a memory location receiving
+                          the handle of the volume root. Must not
+                          be closed by the caller.
+
+  @retval EFI_SUCCESS     No problems were encountered over the
+                          course of execution.
+  @retval other           The operation failed.
+  
+**/
+EFI_STATUS
+GetVolumeRoot(
+	OUT	EFI_FILE_HANDLE	*VolumeRoot)
+{
+	EFI_STATUS				Status;
+	EFI_FILE_IO_INTERFACE	*Volume;
+
+	if (ShimVolumeRoot == NULL) {
+		// Open volume where VgaShim lives.
+		Status = gBS->HandleProtocol(VgaShimImageInfo->DeviceHandle, &gEfiSimpleFileSystemProtocolGuid, (void **)&Volume);
+		if (EFI_ERROR(Status)) {
+			PrintDebug(L"Unable to find simple file system protocol (error: %r)\n", Status);
+			return Status;
+		}
+		Status = Volume->OpenVolume(Volume, &ShimVolumeRoot);
+		if (EFI_ERROR(Status)) {
+			PrintDebug(L"Unable to open volume (error: %r)\n", Status);
+			ShimVolumeRoot = NULL;
+			return Status;
+		}
+		PrintDebug(L"Opened volume\n");
+	}
+	*VolumeRoot = ShimVolumeRoot;
+	return EFI_SUCCESS;
+}
+
+
 /**
   -----------------------------------------------------------------------------
   Exported method implementations.
@@ -98,39 +166,154 @@ BOOLEAN
 FileExists(
 	IN	CHAR16*	FilePath)
 {
-	EFI_STATUS				Status;
-	EFI_FILE_IO_INTERFACE	*Volume;
-	EFI_FILE_HANDLE			VolumeRoot;
-	EFI_FILE_HANDLE			RequestedFile;
+	EFI_FILE_HANDLE	RequestedFile;
 
-	// Open volume where VgaShim lives.
-	Status = gBS->HandleProtocol(VgaShimImageInfo->DeviceHandle, &gEfiSimpleFileSystemProtocolGuid, (void **)&Volume);
-	if (EFI_ERROR(Status)) {
-		PrintDebug(L"Unable to find simple file system protocol (error: %r)\n", Status);
-		return Status;
-	} else {
-		PrintDebug(L"Found simple file system protocol\n");
+	if (EFI_ERROR(FileOpen(FilePath, &RequestedFile))) {
+		return FALSE;
 	}
-	Status = Volume->OpenVolume(Volume, &VolumeRoot);
+	RequestedFile->Close(RequestedFile);
+	return TRUE;
+}
+
+
+/**
+  Opens a file located at a specified path on the filesystem
+  where the VgaShim executable is located for reading, without
+  reading any of its contents. Meant for callers that want to
+  consume the file in smaller portions with FileReadChunked,
+  Read and SetPosition.
+
+  Any error messages will only be printed on the debug console
+  and only the error code returned to caller.
+
+  @param[in] FilePath     Pointer to a string representing a file
+                          path that will be opened.
+
+  @param[out] File        Pointer to a memory location receiving
+                          the handle of the opened file if no
+                          problems were encountered; NULL otherwise.
+                          Caller is responsible for closing it.
+
+  @retval EFI_SUCCESS     No problems were encountered over the
+                          course of execution.
+  @retval other           The operation failed.
+  
+**/
+EFI_STATUS
+FileOpen(
+	IN	CHAR16			*FilePath,
+	OUT	EFI_FILE_HANDLE	*File)
+{
+	EFI_STATUS		Status;
+	EFI_FILE_HANDLE	VolumeRoot;
+
+	*File = NULL;
+	Status = GetVolumeRoot(&VolumeRoot);
 	if (EFI_ERROR(Status)) {
-		PrintDebug(L"Unable to open volume (error: %r)\n", Status);
 		return Status;
-	} else {
-		PrintDebug(L"Opened volume\n");
 	}
 
 	// Try to open file for reading.
-	Status = VolumeRoot->Open(VolumeRoot, &RequestedFile, FilePath, EFI_FILE_MODE_READ, 0);
+	Status = VolumeRoot->Open(VolumeRoot, File, FilePath, EFI_FILE_MODE_READ, 0);
 	if (EFI_ERROR(Status)) {
 		PrintDebug(L"Unable to open file '%s' for reading (error: %r)\n", FilePath, Status);
-		VolumeRoot->Close(VolumeRoot);
-		return FALSE;
+		*File = NULL;
 	} else {
 		PrintDebug(L"Opened file '%s' for reading\n", FilePath);
-		RequestedFile->Close(RequestedFile);
-		VolumeRoot->Close(VolumeRoot);
-		return TRUE;
 	}
+	return Status;
+}
+
+
+/**
+  Retrieves the size of an open file. A buffer big enough for
+  most file names is tried first so that GetInfo usually has
+  to be called only once.
+
+  @param[in] File         Handle of an open file.
+  @param[out] FileBytes   Pointer to a memory location receiving
+                          the size of the file in bytes.
+
+  @retval EFI_SUCCESS     No problems were encountered over the
+                          course of execution.
+  @retval other           The operation failed.
+  
+**/
+EFI_STATUS
+FileGetSize(
+	IN	EFI_FILE_HANDLE	File,
+	OUT	UINT64			*FileBytes)
+{
+	EFI_STATUS		Status;
+	EFI_FILE_INFO	*FileInfo;
+	UINTN			Size;
+
+	Size = SIZE_OF_EFI_FILE_INFO + FILE_INFO_NAME_LENGTH * sizeof(CHAR16);
+	FileInfo = AllocatePool(Size);
+	if (FileInfo == NULL) {
+		return EFI_OUT_OF_RESOURCES;
+	}
+	Status = File->GetInfo(File, &gEfiFileInfoGuid, &Size, FileInfo);
+	if (Status == EFI_BUFFER_TOO_SMALL) {
+		// Size now holds the required buffer size.
+		FreePool(FileInfo);
+		FileInfo = AllocatePool(Size);
+		if (FileInfo == NULL) {
+			return EFI_OUT_OF_RESOURCES;
+		}
+		Status = File->GetInfo(File, &gEfiFileInfoGuid, &Size, FileInfo);
+	}
+	if (EFI_ERROR(Status)) {
+		PrintDebug(L"Unable to get file info (error: %r)\n", Status);
+	} else {
+		*FileBytes = FileInfo->FileSize;
+	}
+	FreePool(FileInfo);
+	return Status;
+}
+
+
+/**
+  Reads up to the specified number of bytes from the current
+  position of an open file into a caller-supplied buffer, in
+  portions of at most FILE_READ_CHUNK_SIZE bytes. File system
+  drivers usually raise the TPL for the duration of a Read, so
+  smaller portions let timer events (such as the animated logo)
+  run in between.
+
+  @param[in] File          Handle of an open file.
+  @param[in,out] Bytes     On input, number of bytes to read. On
+                           output, number of bytes actually read,
+                           which is less only at the end of file.
+  @param[out] Buffer       Buffer at least Bytes long.
+
+  @retval EFI_SUCCESS      No problems were encountered over the
+                           course of execution.
+  @retval other            The operation failed.
+  
+**/
+EFI_STATUS
+FileReadChunked(
+	IN		EFI_FILE_HANDLE	File,
+	IN OUT	UINTN			*Bytes,
+	OUT		VOID			*Buffer)
+{
+	EFI_STATUS	Status;
+	UINTN		BytesRead;
+	UINTN		ChunkBytes;
+
+	Status = EFI_SUCCESS;
+	BytesRead = 0;
+	while (BytesRead < *Bytes) {
+		ChunkBytes = MIN(*Bytes - BytesRead, FILE_READ_CHUNK_SIZE);
+		Status = File->Read(File, &ChunkBytes, (UINT8 *)Buffer + BytesRead);
+		if (EFI_ERROR(Status) || ChunkBytes == 0) {
+			break;
+		}
+		BytesRead += ChunkBytes;
+	}
+	*Bytes = BytesRead;
+	return Status;
 }
 
 
@@ -165,71 +348,50 @@ FileRead(
 	OUT	VOID	**FileContents,
 	OUT	UINTN	*FileBytes)
 {
-	EFI_STATUS				Status;
-	EFI_FILE_IO_INTERFACE	*Volume;
-	EFI_FILE_HANDLE			VolumeRoot;
-	EFI_FILE_HANDLE			File;
-	EFI_FILE_INFO			*FileInfo;
-	UINTN					Size;
+	EFI_STATUS		Status;
+	EFI_FILE_HANDLE	File;
+	UINT64			Size;
+	UINTN			Bytes;
 
-	// Open volume where VgaShim lives.
-	Status = gBS->HandleProtocol(VgaShimImageInfo->DeviceHandle, &gEfiSimpleFileSystemProtocolGuid, (void **)&Volume);
-	if (EFI_ERROR(Status)) {
-		PrintDebug(L"Unable to find simple file system protocol (error: %r)\n", Status);
-		goto Exit;
-	} else {
-		PrintDebug(L"Found simple file system protocol\n");
-	}
-		
-	Status = Volume->OpenVolume(Volume, &VolumeRoot);
+	*FileContents = NULL;
+
+	Status = FileOpen(FilePath, &File);
 	if (EFI_ERROR(Status)) {
-		PrintDebug(L"Unable to open volume (error: %r)\n", Status);
-		goto Exit;
-	} else {
-		PrintDebug(L"Opened volume\n");
+		return Status;
 	}
-	
-	// Try to open file for reading.
-	Status = VolumeRoot->Open(VolumeRoot, &File, FilePath, EFI_FILE_MODE_READ, 0);
+
+	// First gather information on total file size.
+	Status = FileGetSize(File, &Size);
 	if (EFI_ERROR(Status)) {
-		PrintDebug(L"Unable to open file '%s' for reading (error: %r)\n", FilePath, Status);
 		goto Exit;
-	} else {
-		PrintDebug(L"Opened file '%s' for reading\n", FilePath);
 	}
-
-	// First gather information on total file size.
-	File->GetInfo(File, &gEfiFileInfoGuid, &Size, NULL);
-	FileInfo = AllocatePool(Size);
-	if (FileInfo == NULL) {
-		PrintDebug(L"Unable to allocate %u bytes for file info\n", Size);
-		Status = EFI_OUT_OF_RESOURCES;
+	if (Size > MAX_UINTN) {
+		Status = EFI_BAD_BUFFER_SIZE;
 		goto Exit;
-	} else {
-		PrintDebug(L"Allocated %u bytes for file info\n", Size);
 	}
-	File->GetInfo(File, &gEfiFileInfoGuid, &Size, FileInfo);
-	Size = FileInfo->FileSize;
-	FreePool(FileInfo);
 
 	// Allocate a buffer...
-	*FileContents = AllocatePool(Size);
+	Bytes = (UINTN)Size;
+	*FileContents = AllocatePool(Bytes);
 	if (*FileContents == NULL) {
-		PrintDebug(L"Unable to allocate %u bytes for file contents\n", Size);
+		PrintDebug(L"Unable to allocate %u bytes for file contents\n", Bytes);
 		Status = EFI_OUT_OF_RESOURCES;
 		goto Exit;
 	} else {
-		PrintDebug(L"Allocated %u bytes for file contents\n", Size);
+		PrintDebug(L"Allocated %u bytes for file contents\n", Bytes);
 	}
 
 	// ... and read the entire file into it.
-	Status = File->Read(File, &Size, *FileContents);
+	Status = FileReadChunked(File, &Bytes, *FileContents);
+	if (!EFI_ERROR(Status) && Bytes != Size) {
+		Status = EFI_END_OF_FILE;
+	}
 	if (EFI_ERROR(Status)) {
 		PrintDebug(L"Unable to read file contents (error: %r)\n", Status);
 		goto Exit;
 	} else {
-		PrintDebug(L"Read file contents\n", Status);
-		*FileBytes = Size;
+		PrintDebug(L"Read file contents\n");
+		*FileBytes = Bytes;
 	}
 
 Exit:
@@ -238,33 +400,82 @@ Exit:
 		FreePool(*FileContents);
 		*FileContents = NULL;
 	}
-	if (File != NULL)
-		File->Close(File);
-	if (VolumeRoot != NULL)
-		VolumeRoot->Close(VolumeRoot);
+	File->Close(File);
 	return Status;
 }
 
 
+/**
+  Closes the root of the volume where the VgaShim executable is
+  located, if it has been opened. Files opened before stay valid.
+  Should be called before control is passed to another image.
+
+**/
+VOID
+FileCloseVolume()
+{
+	if (ShimVolumeRoot != NULL) {
+		ShimVolumeRoot->Close(ShimVolumeRoot);
+		ShimVolumeRoot = NULL;
+	}
+}
+
+
+/**
+  Loads an EFI executable located at a specified path on the
+  filesystem where the VgaShim executable is located and makes
+  sure it is an EFI loader, without starting it yet.
+
+  The file is read into memory first and handed to LoadImage as
+  a source buffer, so any timer-driven work (such as the animated
+  logo) keeps running in between the disk reads and image loading.
+
+  @param[in] FilePath      Pointer to a string representing the
+                           path of the executable.
+  @param[out] ImageHandle  Pointer to a memory location receiving
+                           the handle of the loaded image.
+
+  @retval EFI_SUCCESS      Image was loaded and is ready to start.
+  @retval other            The operation failed.
+
+**/
 EFI_STATUS
-Launch(
-	IN	CHAR16	*FilePath,
-	IN	VOID	(*WaitForEnterCallback)(BOOLEAN))
+LoadLaunchImage(
+	IN	CHAR16		*FilePath,
+	OUT	EFI_HANDLE	*ImageHandle)
 {
 	EFI_STATUS					Status;
 	EFI_DEVICE_PATH_PROTOCOL	*FilePathOnDevice;
 	EFI_HANDLE					FileImageHandle;
 	EFI_LOADED_IMAGE_PROTOCOL	*FileImageInfo;
 	CHAR16						*FilePathOnDeviceText;
+	VOID						*FileContents = NULL;
+	UINTN						FileBytes = 0;
+
+	*ImageHandle = NULL;
 
 	//
-	// Try to load the image first.
+	// Read the file into memory.
+	//
+	Status = FileRead(FilePath, &FileContents, &FileBytes);
+	if (EFI_ERROR(Status)) {
+		PrintError(L"Unable to read '%s' (error: %r)\n", FilePath, Status);
+		return Status;
+	}
+
+	//
+	// Try to load the image from memory. The device path still
+	// tells the image which device it was loaded from.
 	//
 	FilePathOnDevice = FileDevicePath(VgaShimImageInfo->DeviceHandle, FilePath);
 	FilePathOnDeviceText = ConvertDevicePathToText(FilePathOnDevice, TRUE, FALSE);
-	Status = gBS->LoadImage(TRUE, VgaShimImage, FilePathOnDevice, NULL, 0, &FileImageHandle);
+	Status = gBS->LoadImage(FALSE, VgaShimImage, FilePathOnDevice, FileContents, FileBytes, &FileImageHandle);
+	FreePool(FileContents);
+	FreePool(FilePathOnDevice);
 	if (EFI_ERROR(Status)) {
 		PrintError(L"Unable to load '%s' (error: %r)\n", FilePathOnDeviceText, Status);
+		FreePool(FilePathOnDeviceText);
+		return Status;
 	} else {
 		PrintDebug(L"Loaded '%s'\n", FilePathOnDeviceText);
 		PrintDebug(L"Addresss behind FileImageHandle=%x\n", FileImageHandle);
@@ -272,7 +483,7 @@ Launch(
 	FreePool(FilePathOnDeviceText);
 	
 	// 
-	// Make sure this is a valid EFI loader and fill in the options.
+	// Make sure this is a valid EFI loader.
 	//
 	Status = gBS->HandleProtocol(FileImageHandle, &gEfiLoadedImageProtocolGuid, (VOID *)&FileImageInfo);
 	if (EFI_ERROR(Status) || FileImageInfo->ImageCodeType != EfiLoaderCode) {
@@ -283,6 +494,29 @@ Launch(
 		PrintDebug(L"File matches an EFI loader signature\n");
 	}
 
+	*ImageHandle = FileImageHandle;
+	return EFI_SUCCESS;
+}
+
+
+/**
+  Starts an image previously loaded with LoadLaunchImage.
+
+  @param[in] ImageHandle   Handle of the loaded image.
+  @param[in] WaitForEnterCallback Optional function called right
+                           before the image is started.
+
+  @retval other            Exit status of the started image or
+                           error encountered while starting it.
+
+**/
+EFI_STATUS
+Launch(
+	IN	EFI_HANDLE	ImageHandle,
+	IN	VOID		(*WaitForEnterCallback)(BOOLEAN))
+{
+	EFI_STATUS	Status;
+
 	if (WaitForEnterCallback != NULL) {
 		WaitForEnterCallback(TRUE);
 	}
@@ -290,7 +524,7 @@ Launch(
 	//
 	// Launch!
 	//
-	Status = gBS->StartImage(FileImageHandle, NULL, NULL);
+	Status = gBS->StartImage(ImageHandle, NULL, NULL);
 	if (EFI_ERROR(Status)) {
 		PrintError(L"Unable to start image (error: %r)\n", Status);
 	}
@@ -16,6 +16,17 @@
 #define __FILESYSTEM_H__
 
 
+/**
+  -----------------------------------------------------------------------------
+  Constants.
+  -----------------------------------------------------------------------------
+**/
+
+#define	FILE_READ_CHUNK_SIZE	SIZE_256KB
+#define	FILE_INFO_NAME_LENGTH	0x100
+
+
+
 /**
   -----------------------------------------------------------------------------
   Includes.
@@ -52,16 +63,41 @@ ChangeExtension(
 	IN	CHAR16	*NewExtension,
 	OUT	VOID	**NewFilePath);
 
+EFI_STATUS
+FileOpen(
+	IN	CHAR16			*FilePath,
+	OUT	EFI_FILE_HANDLE	*File);
+
+EFI_STATUS
+FileGetSize(
+	IN		EFI_FILE_HANDLE	File,
+	OUT		UINT64			*FileBytes);
+
+EFI_STATUS
+FileReadChunked(
+	IN		EFI_FILE_HANDLE	File,
+	IN OUT	UINTN			*Bytes,
+	OUT		VOID			*Buffer);
+
 EFI_STATUS
 FileRead(
 	IN	CHAR16	*FilePath,
 	OUT	VOID	**FileContents,
 	OUT	UINTN	*FileBytes);
 
+VOID
+FileCloseVolume(
+	VOID);
+
+EFI_STATUS
+LoadLaunchImage(
+	IN	CHAR16		*FilePath,
+	OUT	EFI_HANDLE	*ImageHandle);
+
 EFI_STATUS
 Launch(
-	IN	CHAR16	*FilePath,
-	IN	VOID	(*WaitForEnterCallback)(BOOLEAN));
+	IN	EFI_HANDLE	ImageHandle,
+	IN	VOID		(*WaitForEnterCallback)(BOOLEAN));
 
 
 /**
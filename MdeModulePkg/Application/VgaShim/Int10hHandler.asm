@@ -1,7 +1,8 @@
 ;------------------------------------------------------------------------------
 ; @file
 ; A minimal Int10h stub that allows the Windows 7 SP1 default VGA driver to
-; 'swithc' to the 1024x768x32 video mode on MacBookAir7,2 and possibly other
+; 'swithc' to one of the 32bpp video modes listed by the efi shim (1024x768
+; and the native resolution among them) on MacBookAir7,2 and possibly other
 ; Apple laptops that do not have a VGA ROM / Int10h handler.
 
 ; Adapted from VbeShim.asm from the Qemu project.
@@ -31,6 +32,8 @@ TIMES 256 nop							; this will be filled in by the efi shim
 
 VbeModeInfo:
 TIMES 256 nop							; this will be filled in by the efi shim
+										; (first mode in the list; other modes
+										; follow the code at VbeModeInfoExtra)
 
 
 InterruptHandlerEntry:
@@ -101,22 +104,26 @@ GetModeInfo:
   push       si
   push       cx
   and        cx, ~0x4000	; clear potentially set LFB (linear frame buffer) bit in mode number
-  cmp        cx, 0x00f1		; offer information on only known mode
-  je         GetKnownModeInfo1
-  jmp        Hang
-GetKnownModeInfo1:
+  call       FindMode			; look the mode up in the mode list
+  jc         GetModeInfoUnknown
   push       cs
   pop        ds						; load the code segment address to DS
-  mov        si, VbeModeInfo ; load offset of VbeModeInfo from program start to SI
   mov        cx, 256			; we want to copy 256 bytes
   cld											; clear direction flag
-  rep movsb								; move 256 bytes of VbeModeInfo at DS:SI to buffer at ES:DI
+  rep movsb								; move 256 bytes of mode information at DS:SI to buffer at ES:DI
   pop        cx						; restore registers from stack
   pop        si
   pop        ds
   pop        di
   pop        es
   jmp        Success			; ax=0x4f
+GetModeInfoUnknown:
+  pop        cx						; restore registers from stack
+  pop        si
+  pop        ds
+  pop        di
+  pop        es
+  jmp        Unsupported	; ax=0x014f
 
 
 SetMode:
@@ -127,22 +134,23 @@ SetMode:
 	;   ES:DI = pointer to VESA_BIOS_EXTENSIONS_CRTC_INFORMATION_BLOCK structure
 	; Outputs:
 	;   AX    = return status
-  push       dx						; store registers on stack
-  push       ax
-  cmp        bx, 0x40f1		; 0x40f1 mode
-													; <15>=0 Clear display memory
-													; <14>=1 Use linear/flat frame buffer model
-													; <13:12>=00 Reserved (must be 0)
-													; <11>=0 Use current default refresh rate
-													; <10:9>00
-													; <8:0>=011110001 Mode Number 241 ???
-													; to identify available modes use sudo hwinfo --framebuffer
-  je         SetKnownMode1
-  jmp        Hang
-SetKnownMode1:
-  ; everything is done by the efi shim
-  pop        ax						; restore registers from stack
-  pop        dx
+	; Notes:
+	;   BX<15>=0 Clear display memory
+	;   BX<14>=1 Use linear/flat frame buffer model
+	;   BX<13:12>=00 Reserved (must be 0)
+	;   BX<11>=0 Use current default refresh rate
+	;   BX<10:9>=00
+	;   BX<8:0> Mode Number, eg. 011110001 for 241 (0xf1)
+	;   to identify available modes use sudo hwinfo --framebuffer
+  push       cx						; store registers on stack
+  push       si
+  mov        cx, bx
+  and        cx, 0x01ff		; keep the mode number only
+  call       FindMode			; accept any mode in the mode list
+  pop        si						; restore registers from stack
+  pop        cx
+  jc         Unsupported	; ax=0x014f
+  ; everything else is done by the efi shim
   jmp        Success 			; ax=0x4f
 
 
@@ -153,7 +161,12 @@ GetMode:
 	; Outputs:
 	;   AX    = return status
 	;   BX    = current mode
-  mov        bx, 0x40f1
+	; Notes:
+	;   This memory may be write-protected, so the mode that was set cannot
+	;   be remembered; report the first mode in the list (1024x768).
+  mov        bx, [cs:VbeInfo + 0x0e]	; offset of the mode list
+  mov        bx, [cs:bx]	; first mode number
+  or         bx, 0x4000		; linear frame buffer
   jmp        Success ; ax=0x4f
 
 
@@ -204,6 +217,41 @@ SetModeLegacyDone:
   iret
 
 
+FindMode:
+  ; Looks a mode number up in the mode list.
+  ; Inputs:
+	;   CX    = mode number
+	; Outputs:
+	;   CF    = clear if found, set otherwise
+	;   SI    = offset of VESA_BIOS_EXTENSIONS_MODE_INFORMATION_BLOCK for the mode
+	; Notes:
+	;   Information for the first listed mode is at VbeModeInfo, information
+	;   for the following ones is stored 256 bytes apart from VbeModeInfoExtra.
+  push       bx						; store registers on stack
+  mov        bx, [cs:VbeInfo + 0x0e]	; offset of the mode list
+  mov        si, VbeModeInfo
+FindModeLoop:
+  cmp        word [cs:bx], 0xffff	; end of the mode list?
+  je         FindModeUnknown
+  cmp        cx, [cs:bx]
+  je         FindModeKnown
+  add        bx, 2				; next mode number...
+  cmp        si, VbeModeInfo
+  jne        FindModeNext
+  mov        si, VbeModeInfoExtra - 256
+FindModeNext:
+  add        si, 256			; ...and its mode information
+  jmp        FindModeLoop
+FindModeKnown:
+  pop        bx						; restore registers from stack
+  clc
+  ret
+FindModeUnknown:
+  pop        bx						; restore registers from stack
+  stc
+  ret
+
+
 Success:
   mov        ax, 0x004f
   iret
@@ -212,3 +260,7 @@ Success:
 Unsupported:
   mov        ax, 0x014f
   iret
+
+
+VbeModeInfoExtra:
+													; this will be filled in by the efi shim
@@ -520,17 +520,17 @@ STATIC CONST UINT8 INT10H_HANDLER[] = {
   /* 00000200 cmp ax,0x4f00                  */  0x3D, 0x00, 0x4F,
   /* 00000203 jz 0x225                       */  0x74, 0x20,
   /* 00000205 cmp ax,0x4f01                  */  0x3D, 0x01, 0x4F,
-  /* 00000208 jz 0x23c                       */  0x74, 0x32,
+  /* 00000208 jz 0x23d                       */  0x74, 0x33,
   /* 0000020A cmp ax,0x4f02                  */  0x3D, 0x02, 0x4F,
-  /* 0000020D jz 0x25f                       */  0x74, 0x50,
+  /* 0000020D jz 0x261                       */  0x74, 0x52,
   /* 0000020F cmp ax,0x4f03                  */  0x3D, 0x03, 0x4F,
-  /* 00000212 jz 0x26d                       */  0x74, 0x59,
+  /* 00000212 jz 0x272                       */  0x74, 0x5E,
   /* 00000214 cmp ax,0x4f10                  */  0x3D, 0x10, 0x4F,
-  /* 00000217 jz 0x272                       */  0x74, 0x59,
+  /* 00000217 jz 0x280                       */  0x74, 0x67,
   /* 00000219 cmp ax,0x4f15                  */  0x3D, 0x15, 0x4F,
-  /* 0000021C jz 0x274                       */  0x74, 0x56,
+  /* 0000021C jz 0x282                       */  0x74, 0x64,
   /* 0000021E cmp ah,0x0                     */  0x80, 0xFC, 0x00,
-  /* 00000221 jz 0x276                       */  0x74, 0x53,
+  /* 00000221 jz 0x284                       */  0x74, 0x61,
   /* 00000223 jmp short 0x223                */  0xEB, 0xFE,
   /* 00000225 push es                        */  0x06,
   /* 00000226 push di                        */  0x57,
@@ -548,52 +548,78 @@ STATIC CONST UINT8 INT10H_HANDLER[] = {
   /* 00000237 pop ds                         */  0x1F,
   /* 00000238 pop di                         */  0x5F,
   /* 00000239 pop es                         */  0x07,
-  /* 0000023A jmp short 0x287                */  0xEB, 0x4B,
-  /* 0000023C push es                        */  0x06,
-  /* 0000023D push di                        */  0x57,
-  /* 0000023E push ds                        */  0x1E,
-  /* 0000023F push si                        */  0x56,
-  /* 00000240 push cx                        */  0x51,
-  /* 00000241 and cx,0xbfff                  */  0x81, 0xE1, 0xFF, 0xBF,
-  /* 00000245 cmp cx,0xf1                    */  0x81, 0xF9, 0xF1, 0x00,
-  /* 00000249 jz 0x24d                       */  0x74, 0x02,
-  /* 0000024B jmp short 0x223                */  0xEB, 0xD6,
-  /* 0000024D push cs                        */  0x0E,
-  /* 0000024E pop ds                         */  0x1F,
-  /* 0000024F mov si,0x100                   */  0xBE, 0x00, 0x01,
-  /* 00000252 mov cx,0x100                   */  0xB9, 0x00, 0x01,
-  /* 00000255 cld                            */  0xFC,
-  /* 00000256 rep movsb                      */  0xF3, 0xA4,
-  /* 00000258 pop cx                         */  0x59,
-  /* 00000259 pop si                         */  0x5E,
-  /* 0000025A pop ds                         */  0x1F,
-  /* 0000025B pop di                         */  0x5F,
-  /* 0000025C pop es                         */  0x07,
-  /* 0000025D jmp short 0x287                */  0xEB, 0x28,
-  /* 0000025F push dx                        */  0x52,
-  /* 00000260 push ax                        */  0x50,
-  /* 00000261 cmp bx,0x40f1                  */  0x81, 0xFB, 0xF1, 0x40,
-  /* 00000265 jz 0x269                       */  0x74, 0x02,
-  /* 00000267 jmp short 0x223                */  0xEB, 0xBA,
-  /* 00000269 pop ax                         */  0x58,
-  /* 0000026A pop dx                         */  0x5A,
-  /* 0000026B jmp short 0x287                */  0xEB, 0x1A,
-  /* 0000026D mov bx,0x40f1                  */  0xBB, 0xF1, 0x40,
-  /* 00000270 jmp short 0x287                */  0xEB, 0x15,
-  /* 00000272 jmp short 0x28b                */  0xEB, 0x17,
-  /* 00000274 jmp short 0x28b                */  0xEB, 0x15,
-  /* 00000276 cmp al,0x3                     */  0x3C, 0x03,
-  /* 00000278 jz 0x280                       */  0x74, 0x06,
-  /* 0000027A cmp al,0x12                    */  0x3C, 0x12,
-  /* 0000027C jz 0x284                       */  0x74, 0x06,
-  /* 0000027E jmp short 0x223                */  0xEB, 0xA3,
-  /* 00000280 mov al,0x30                    */  0xB0, 0x30,
-  /* 00000282 jmp short 0x286                */  0xEB, 0x02,
-  /* 00000284 mov al,0x20                    */  0xB0, 0x20,
-  /* 00000286 iretw                          */  0xCF,
-  /* 00000287 mov ax,0x4f                    */  0xB8, 0x4F, 0x00,
-  /* 0000028A iretw                          */  0xCF,
-  /* 0000028B mov ax,0x14f                   */  0xB8, 0x4F, 0x01,
-  /* 0000028E iretw                          */  0xCF,
+  /* 0000023A jmp 0x2c1                      */  0xE9, 0x84, 0x00,
+  /* 0000023D push es                        */  0x06,
+  /* 0000023E push di                        */  0x57,
+  /* 0000023F push ds                        */  0x1E,
+  /* 00000240 push si                        */  0x56,
+  /* 00000241 push cx                        */  0x51,
+  /* 00000242 and cx,0xbfff                  */  0x81, 0xE1, 0xFF, 0xBF,
+  /* 00000246 call word 0x295                */  0xE8, 0x4C, 0x00,
+  /* 00000249 jc 0x25a                       */  0x72, 0x0F,
+  /* 0000024B push cs                        */  0x0E,
+  /* 0000024C pop ds                         */  0x1F,
+  /* 0000024D mov cx,0x100                   */  0xB9, 0x00, 0x01,
+  /* 00000250 cld                            */  0xFC,
+  /* 00000251 rep movsb                      */  0xF3, 0xA4,
+  /* 00000253 pop cx                         */  0x59,
+  /* 00000254 pop si                         */  0x5E,
+  /* 00000255 pop ds                         */  0x1F,
+  /* 00000256 pop di                         */  0x5F,
+  /* 00000257 pop es                         */  0x07,
+  /* 00000258 jmp short 0x2c1                */  0xEB, 0x67,
+  /* 0000025A pop cx                         */  0x59,
+  /* 0000025B pop si                         */  0x5E,
+  /* 0000025C pop ds                         */  0x1F,
+  /* 0000025D pop di                         */  0x5F,
+  /* 0000025E pop es                         */  0x07,
+  /* 0000025F jmp short 0x2c5                */  0xEB, 0x64,
+  /* 00000261 push cx                        */  0x51,
+  /* 00000262 push si                        */  0x56,
+  /* 00000263 mov cx,bx                      */  0x89, 0xD9,
+  /* 00000265 and cx,0x1ff                   */  0x81, 0xE1, 0xFF, 0x01,
+  /* 00000269 call word 0x295                */  0xE8, 0x29, 0x00,
+  /* 0000026C pop si                         */  0x5E,
+  /* 0000026D pop cx                         */  0x59,
+  /* 0000026E jc 0x2c5                       */  0x72, 0x55,
+  /* 00000270 jmp short 0x2c1                */  0xEB, 0x4F,
+  /* 00000272 mov bx,[cs:0xe]                */  0x2E, 0x8B, 0x1E, 0x0E, 0x00,
+  /* 00000277 mov bx,[cs:bx]                 */  0x2E, 0x8B, 0x1F,
+  /* 0000027A or bx,0x4000                   */  0x81, 0xCB, 0x00, 0x40,
+  /* 0000027E jmp short 0x2c1                */  0xEB, 0x41,
+  /* 00000280 jmp short 0x2c5                */  0xEB, 0x43,
+  /* 00000282 jmp short 0x2c5                */  0xEB, 0x41,
+  /* 00000284 cmp al,0x3                     */  0x3C, 0x03,
+  /* 00000286 jz 0x28e                       */  0x74, 0x06,
+  /* 00000288 cmp al,0x12                    */  0x3C, 0x12,
+  /* 0000028A jz 0x292                       */  0x74, 0x06,
+  /* 0000028C jmp short 0x223                */  0xEB, 0x95,
+  /* 0000028E mov al,0x30                    */  0xB0, 0x30,
+  /* 00000290 jmp short 0x294                */  0xEB, 0x02,
+  /* 00000292 mov al,0x20                    */  0xB0, 0x20,
+  /* 00000294 iretw                          */  0xCF,
+  /* 00000295 push bx                        */  0x53,
+  /* 00000296 mov bx,[cs:0xe]                */  0x2E, 0x8B, 0x1E, 0x0E, 0x00,
+  /* 0000029B mov si,0x100                   */  0xBE, 0x00, 0x01,
+  /* 0000029E cmp word [cs:bx],0xffff        */  0x2E, 0x83, 0x3F, 0xFF,
+  /* 000002A2 jz 0x2be                       */  0x74, 0x1A,
+  /* 000002A4 cmp cx,[cs:bx]                 */  0x2E, 0x3B, 0x0F,
+  /* 000002A7 jz 0x2bb                       */  0x74, 0x12,
+  /* 000002A9 add bx,0x2                     */  0x83, 0xC3, 0x02,
+  /* 000002AC cmp si,0x100                   */  0x81, 0xFE, 0x00, 0x01,
+  /* 000002B0 jnz 0x2b5                      */  0x75, 0x03,
+  /* 000002B2 mov si,0x1c9                   */  0xBE, 0xC9, 0x01,
+  /* 000002B5 add si,0x100                   */  0x81, 0xC6, 0x00, 0x01,
+  /* 000002B9 jmp short 0x29e                */  0xEB, 0xE3,
+  /* 000002BB pop bx                         */  0x5B,
+  /* 000002BC clc                            */  0xF8,
+  /* 000002BD ret                            */  0xC3,
+  /* 000002BE pop bx                         */  0x5B,
+  /* 000002BF stc                            */  0xF9,
+  /* 000002C0 ret                            */  0xC3,
+  /* 000002C1 mov ax,0x4f                    */  0xB8, 0x4F, 0x00,
+  /* 000002C4 iretw                          */  0xCF,
+  /* 000002C5 mov ax,0x14f                   */  0xB8, 0x4F, 0x01,
+  /* 000002C8 iretw                          */  0xCF,
 };
 #endif
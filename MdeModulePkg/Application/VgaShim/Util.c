@@ -14,6 +14,22 @@
 
 #include "Util.h"
 
+
+/**
+  -----------------------------------------------------------------------------
+  Variables.
+  -----------------------------------------------------------------------------
+**/
+
+STATIC struct {
+	CONST CHAR8		*Stage;
+	UINT64			Start;
+	UINT64			End;
+} TimingRecords[MAX_TIMING_RECORDS];
+STATIC UINTN		NumTimingRecords = 0;
+
+
+
 VOID
 StrToLowercase(
 	IN	CHAR16	*String)
@@ -25,4 +41,146 @@ StrToLowercase(
 			*TmpStr = (CHAR16)(*TmpStr - L'A' + L'a');
 		}
 	}
-}
\ No newline at end of file
+}
+
+
+/**
+  Returns the current value of the processor time stamp counter.
+  Use TimestampToMicroseconds to convert differences between
+  two timestamps into time.
+
+  @retval UINT64          Current time stamp counter value.
+
+**/
+UINT64
+GetTimestamp()
+{
+	return AsmReadTsc();
+}
+
+
+/**
+  Converts a number of time stamp counter ticks into microseconds.
+  The counter frequency is measured against gBS->Stall on first use.
+
+  @param[in] Ticks        Difference between two timestamps.
+
+  @retval UINT64          Number of microseconds the ticks represent.
+
+**/
+UINT64
+TimestampToMicroseconds(
+	IN	UINT64	Ticks)
+{
+	STATIC UINT64	TicksPerMs = 0;
+	UINT64			Start;
+
+	if (TicksPerMs == 0) {
+		Start = AsmReadTsc();
+		gBS->Stall(1000);
+		TicksPerMs = AsmReadTsc() - Start;
+		if (TicksPerMs == 0) {
+			TicksPerMs = 1;
+		}
+	}
+	return DivU64x64Remainder(MultU64x32(Ticks, 1000), TicksPerMs, NULL);
+}
+
+
+/**
+  Marks the beginning of a boot stage. Along with the local record
+  a PERF_START entry is logged so that the stage shows up in Dp
+  on firmware that supports performance measurement.
+
+  Stages may nest but the same stage should not be open twice.
+  Once MAX_TIMING_RECORDS stages have been recorded, further
+  stages are silently ignored.
+
+  @param[in] Stage        Name of the stage; has to remain valid
+                          until TimingPublish is called.
+
+**/
+VOID
+TimingStart(
+	IN CONST	CHAR8	*Stage)
+{
+	if (NumTimingRecords >= MAX_TIMING_RECORDS) {
+		return;
+	}
+	TimingRecords[NumTimingRecords].Stage = Stage;
+	TimingRecords[NumTimingRecords].End = 0;
+	TimingRecords[NumTimingRecords].Start = GetTimestamp();
+	NumTimingRecords++;
+	PERF_START(gImageHandle, Stage, NULL, 0);
+}
+
+
+/**
+  Marks the end of a boot stage previously started with TimingStart.
+
+  @param[in] Stage        Name of the stage.
+
+**/
+VOID
+TimingEnd(
+	IN CONST	CHAR8	*Stage)
+{
+	UINT64	Timestamp;
+	UINTN	Index;
+
+	Timestamp = GetTimestamp();
+	PERF_END(gImageHandle, Stage, NULL, 0);
+	for (Index = NumTimingRecords; Index > 0; Index--) {
+		if (TimingRecords[Index - 1].End == 0
+			&& AsciiStrCmp(TimingRecords[Index - 1].Stage, Stage) == 0) {
+			TimingRecords[Index - 1].End = Timestamp;
+			return;
+		}
+	}
+}
+
+
+/**
+  Publishes all recorded stages as a volatile UEFI variable
+  (TIMING_VARIABLE_NAME under the VgaShim file GUID) holding
+  an array of TIMING_RECORD entries, so that it can be read
+  by the OS once booted, eg. to compare firmware versions.
+
+  @retval EFI_SUCCESS     The variable was set.
+  @retval other           Nothing was recorded or the variable
+                          could not be set.
+
+**/
+EFI_STATUS
+TimingPublish()
+{
+	EFI_STATUS		Status;
+	TIMING_RECORD	*Records;
+	UINT64			Origin;
+	UINTN			Index;
+
+	if (NumTimingRecords == 0) {
+		return EFI_NOT_FOUND;
+	}
+	Records = AllocateZeroPool(NumTimingRecords * sizeof(TIMING_RECORD));
+	if (Records == NULL) {
+		return EFI_OUT_OF_RESOURCES;
+	}
+
+	Origin = TimingRecords[0].Start;
+	for (Index = 0; Index < NumTimingRecords; Index++) {
+		AsciiStrnCpyS(Records[Index].Stage, TIMING_STAGE_LENGTH,
+			TimingRecords[Index].Stage, TIMING_STAGE_LENGTH - 1);
+		Records[Index].StartUs = TimestampToMicroseconds(TimingRecords[Index].Start - Origin);
+		if (TimingRecords[Index].End != 0) {
+			Records[Index].DurationUs = TimestampToMicroseconds(
+				TimingRecords[Index].End - TimingRecords[Index].Start);
+		}
+	}
+
+	Status = gRT->SetVariable(TIMING_VARIABLE_NAME, &gEfiCallerIdGuid,
+		EFI_VARIABLE_BOOTSERVICE_ACCESS | EFI_VARIABLE_RUNTIME_ACCESS,
+		NumTimingRecords * sizeof(TIMING_RECORD), Records);
+	FreePool(Records);
+	return Status;
+}
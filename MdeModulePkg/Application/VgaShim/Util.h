@@ -23,6 +23,9 @@
 **/
 
 #define	DEBUG_MESSAGE_LENGTH	0x100
+#define	MAX_TIMING_RECORDS		16
+#define	TIMING_STAGE_LENGTH		24
+#define	TIMING_VARIABLE_NAME	L"VgaShimTimings"
 
 
 
@@ -33,6 +36,31 @@
 **/
 
 #include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/PerformanceLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/UefiRuntimeServicesTableLib.h>
+
+
+/**
+  -----------------------------------------------------------------------------
+  Type definitions and enums.
+  -----------------------------------------------------------------------------
+**/
+
+//
+// Layout of each entry of the TIMING_VARIABLE_NAME variable, published
+// under the VgaShim file GUID. Times are relative to the first recorded
+// stage; DurationUs is 0 for stages that were started but never ended.
+//
+#pragma pack(1)
+typedef struct {
+	CHAR8			Stage[TIMING_STAGE_LENGTH];
+	UINT64			StartUs;
+	UINT64			DurationUs;
+} TIMING_RECORD;
+#pragma pack()
 
 
 /**
@@ -45,6 +73,26 @@ VOID
 StrToLowercase(
 	IN			CHAR16	*String);
 
+UINT64
+GetTimestamp(
+	VOID);
+
+UINT64
+TimestampToMicroseconds(
+	IN			UINT64	Ticks);
+
+VOID
+TimingStart(
+	IN CONST	CHAR8	*Stage);
+
+VOID
+TimingEnd(
+	IN CONST	CHAR8	*Stage);
+
+EFI_STATUS
+TimingPublish(
+	VOID);
+
 VOID
 EFIAPI
 PrintFuncNameMessage(
@@ -15,6 +15,9 @@
 #include "VgaShim.h"
 #include "Display.h"
 #include "Util.h"
+#ifdef VGA_SHIM_BENCHMARK
+#include "Benchmark.h"
+#endif
 #include "Filesystem.h"
 #include "Int10hHandler.h"
 #include "BootflagSimple.h"
@@ -31,6 +34,8 @@ DISPLAY_INFO					DisplayInfo;
 EFI_HANDLE						VgaShimImage;
 EFI_LOADED_IMAGE_PROTOCOL		*VgaShimImageInfo;
 BOOLEAN							DebugMode = FALSE;
+BMP_ANIMATION					*LogoAnimation = NULL;
+UINT64							ShimStartTimestamp;
 
 
 /**
@@ -57,7 +62,7 @@ UefiMain (
 	EFI_STATUS				Status;
 	EFI_STATUS				IvtAllocationStatus;
 	EFI_INPUT_KEY			Key;
-	CHAR16					*LaunchPath = NULL;
+	EFI_HANDLE				LaunchImage = NULL;
 
 	//
 	// Claim real mode IVT memory area before any allocation can
@@ -66,6 +71,8 @@ UefiMain (
 	//
 	IvtAddress = IVT_ADDRESS;
 	IvtAllocationStatus = gBS->AllocatePages(AllocateAddress, EfiBootServicesCode, 1, &IvtAddress);
+	ShimStartTimestamp = GetTimestamp();
+	TimingStart("Shim");
 
 	//
 	// Initialization.
@@ -91,13 +98,24 @@ UefiMain (
 	}
 
 	// 
-	// Show pretty graphics.
+	// Show pretty graphics. An animated logo keeps playing
+	// in the background while the shim is being set up.
 	//
 	if (!DebugMode) {
 		if (!ShowAnimatedLogo()) {
 			ShowStaticLogo();
 		}
 	}
+	LogStage(L"Logo shown");
+
+	//
+	// Read and load Windows Boot Manager while the logo
+	// is still on screen; it will only be started at the end.
+	//
+	TimingStart("LoadBootManager");
+	LoadBootManager(&LaunchImage);
+	TimingEnd("LoadBootManager");
+	LogStage(L"Windows Boot Manager loaded");
 
 	//
 	// If an Int10h handler exists there either is a real
@@ -120,7 +138,9 @@ UefiMain (
 	//
 	// Unlock VGA ROM memory area for writing first.
 	//
+	TimingStart("MemoryUnlock");
 	Status = EnsureMemoryLock(VGA_ROM_ADDRESS, VGA_ROM_SIZE, UNLOCK);
+	TimingEnd("MemoryUnlock");
 	if (EFI_ERROR(Status)) {
 		PrintError(L"Unable to unlock VGA ROM memory at %04x, aborting\n", VGA_ROM_ADDRESS);
 		goto Exit;
@@ -131,7 +151,9 @@ UefiMain (
 	//
 	SetMem((VOID *)VGA_ROM_ADDRESS, VGA_ROM_SIZE, 0);
 	CopyMem((VOID *)VGA_ROM_ADDRESS, INT10H_HANDLER, sizeof INT10H_HANDLER);
+	TimingStart("VesaInformation");
 	Status = ShimVesaInformation(VGA_ROM_ADDRESS, &Int10hHandlerAddress);
+	TimingEnd("VesaInformation");
 	if (EFI_ERROR(Status)) {
 		PrintError(L"VESA information could not be filled in, aborting\n");
 		goto Exit;
@@ -146,7 +168,9 @@ UefiMain (
 	//
 	// Lock VGA ROM memory area to prevent further writes.
 	//
+	TimingStart("MemoryLock");
 	Status = EnsureMemoryLock(VGA_ROM_ADDRESS, VGA_ROM_SIZE, LOCK);
+	TimingEnd("MemoryLock");
 	if (EFI_ERROR(Status)) {
 		PrintDebug(L"Unable to lock VGA ROM memory at %x but this is not essential\n", 
 			VGA_ROM_ADDRESS);
@@ -176,16 +200,16 @@ UefiMain (
 	}
 	
 Exit:
+	LogStage(L"Shim set up");
+
 	//
-	// Check if we can chainload the Windows Boot Manager.
+	// Let the animation play till the end.
 	//
-	if (FileExists(L"\\efi\\microsoft\\boot\\bootmgfw.efi")) {
-		LaunchPath = L"\\efi\\microsoft\\boot\\bootmgfw.efi";
-		PrintDebug(L"Found Windows Boot Manager at '%s'\n", LaunchPath);
-	} else {
-		PrintError(L"Could not find Windows Boot Manager, press Enter to exit\n");
-		WaitForEnter(FALSE);
-	}
+	TimingStart("LogoFinish");
+	FinishAnimatedLogo(TRUE);
+	TimingEnd("LogoFinish");
+	FileCloseVolume();
+	LogStage(L"Logo finished");
 
 	//
 	// Make it possible to enter Windows Boot Manager.
@@ -203,23 +227,120 @@ Exit:
 		// waiting will be done by the Lauch method.
 	}
 	
-	if (LaunchPath != NULL) {
-		Launch(LaunchPath, DebugMode ? &WaitForEnterAndStall : NULL);
+	//
+	// Leave timings behind for the OS; StartImage does not return.
+	//
+	TimingEnd("Shim");
+	Status = TimingPublish();
+	if (EFI_ERROR(Status)) {
+		PrintDebug(L"Unable to publish boot stage timings (%r)\n", Status);
+	}
+
+	if (LaunchImage != NULL) {
+		LogStage(L"Starting Windows Boot Manager");
+		Launch(LaunchImage, DebugMode ? &WaitForEnterAndStall : NULL);
 	}
 
 	return EFI_SUCCESS;
 }
 
 
+#ifdef VGA_SHIM_BENCHMARK
+/**
+  The entry point for the benchmark build of the application
+  (VgaShimBenchmark.inf). Runs the benchmarks without touching
+  VGA ROM and IVT and without waiting for the user.
+
+  @param[in] ImageHandle    The firmware allocated handle for the EFI image.
+  @param[in] SystemTable    A pointer to the EFI System Table.
+
+  @retval EFI_SUCCESS       All benchmarks ran and their results were consistent.
+  @retval other             Some benchmark failed or produced inconsistent results.
+
+**/
+EFI_STATUS
+EFIAPI
+BenchmarkMain (
+	IN EFI_HANDLE		ImageHandle,
+	IN EFI_SYSTEM_TABLE	*SystemTable)
+{
+	EFI_STATUS	Status;
+
+	ShimStartTimestamp = GetTimestamp();
+	VgaShimImage = ImageHandle;
+	Status = gBS->HandleProtocol(VgaShimImage, &gEfiLoadedImageProtocolGuid, (VOID **)&VgaShimImageInfo);
+	if (EFI_ERROR(Status)) {
+		PrintError(L"Unable to locate EFI_LOADED_IMAGE_PROTOCOL, aborting\n");
+		return Status;
+	}
+
+	Status = RunBenchmarks(BootflagSimple);
+	PrintDebug(L"Benchmarks finished (%r)\n", Status);
+	FileCloseVolume();
+	return Status;
+}
+#endif
+
+
+/**
+  Checks if the Windows Boot Manager can be chainloaded and, if so,
+  reads it into memory and loads it so that it is ready to start.
+
+  @param[out] LaunchImage   Pointer to a memory location receiving
+                            the handle of the loaded image, or NULL
+                            if it could not be loaded.
+
+**/
+VOID
+LoadBootManager(
+	OUT	EFI_HANDLE	*LaunchImage)
+{
+	CHAR16	*LaunchPath = L"\\efi\\microsoft\\boot\\bootmgfw.efi";
+
+	*LaunchImage = NULL;
+	if (FileExists(LaunchPath)) {
+		PrintDebug(L"Found Windows Boot Manager at '%s'\n", LaunchPath);
+		LoadLaunchImage(LaunchPath, LaunchImage);
+	} else {
+		PrintError(L"Could not find Windows Boot Manager, press Enter to exit\n");
+		WaitForEnter(FALSE);
+	}
+}
+
+
+/**
+  Prints how much time has passed since the shim was started,
+  so that the duration of each boot stage can be followed on
+  the debug console.
+
+  @param[in] Stage          Name of the stage just reached.
+
+**/
+VOID
+LogStage(
+	IN	CHAR16	*Stage)
+{
+	PrintDebug(L"%s after %lu us\n", Stage,
+		TimestampToMicroseconds(GetTimestamp() - ShimStartTimestamp));
+}
+
+
 /**
   Fills in VESA-compatible information about supported video modes
   in the space left for this purpose at the beginning of the 
   generated VGA ROM assembly code.
   (See VESA BIOS EXTENSION Core Functions Standard v3.0, p26+.)
 
+  Real-mode code cannot switch the GOP mode, so all listed modes are
+  windows centered in the framebuffer of the current mode: 1024x768
+  (as expected by the Windows installer) comes first, followed by the
+  native resolution and any other GOP resolutions that fit on screen.
+  Information for the first mode is written right after the general
+  information, for the following ones right after the handler code.
+
   @param[in] StartAddress Where to begin writing VESA information.
-  @param[in] EndAddress   Pointer to the next byte after the end
-                          of all video mode information data.
+  @param[in] EndAddress   Pointer to the entry point of the handler
+                          code that follows the video mode information.
 
   @retval EFI_SUCCESS     The operation was successful
   @return other           The operation failed.
@@ -230,13 +351,16 @@ ShimVesaInformation(
 	IN	EFI_PHYSICAL_ADDRESS	StartAddress,
 	OUT	EFI_PHYSICAL_ADDRESS	*EndAddress)
 {
+	EFI_STATUS				Status;
 	VBE_INFO				*VbeInfoFull;
 	VBE_INFO_BASE			*VbeInfo;
 	VBE_MODE_INFO			*VbeModeInfo;
 	UINT8					*BufferPtr;
-	UINT32					HorizontalOffsetPx;
-	UINT32					VerticalOffsetPx;
-	EFI_PHYSICAL_ADDRESS	FrameBufferBaseWithOffset;
+	UINT16					*ModeList;
+	UINT32					ModeWidth[MAX_VESA_MODES];
+	UINT32					ModeHeight[MAX_VESA_MODES];
+	UINTN					NumModes;
+	UINTN					Index;
 
 	//
 	// Get basic video hardware information first.
@@ -245,6 +369,18 @@ ShimVesaInformation(
 		PrintError(L"No display adapters were found, unable to fill in VESA information\n");
 		return EFI_NOT_FOUND;
 	}
+
+	//
+	// Collect resolutions to be offered.
+	//
+	NumModes = 0;
+	ModeWidth[NumModes] = 1024;						// as expected by Windows installer
+	ModeHeight[NumModes++] = 768;					// as expected by Windows installer
+	AddVesaMode(ModeWidth, ModeHeight, &NumModes,
+		DisplayInfo.HorizontalResolution, DisplayInfo.VerticalResolution);
+	if (DisplayInfo.Protocol == GOP) {
+		CollectGopModes(ModeWidth, ModeHeight, &NumModes);
+	}
 	
 	//
 	// VESA general information.
@@ -259,10 +395,12 @@ ShimVesaInformation(
 	BufferPtr += sizeof VENDOR_NAME;
 	VbeInfo->Capabilities = BIT0;			// DAC width supports 8-bit color mode
 	VbeInfo->ModeListAddress = (UINT32)StartAddress << 12 | (UINT16)(UINTN)BufferPtr;
-	*(UINT16*)BufferPtr = 0x00f1;			// mode number
-	BufferPtr += 2;
-	*(UINT16*)BufferPtr = 0xFFFF;			// mode list terminator
-	BufferPtr += 2;
+	ModeList = (UINT16 *)BufferPtr;
+	for (Index = 0; Index < NumModes; Index++) {
+		*ModeList++ = (UINT16)(FIRST_VESA_MODE + Index);	// mode number
+	}
+	*ModeList++ = 0xFFFF;					// mode list terminator
+	BufferPtr = (UINT8 *)ModeList;
 	VbeInfo->VideoMem64K = (UINT16)((DisplayInfo.FrameBufferSize + 65535) / 65536);
 	VbeInfo->OemSoftwareVersion = 0x0000;
 	VbeInfo->VendorNameAddress = (UINT32)StartAddress << 12 | (UINT16)(UINTN)BufferPtr;
@@ -276,9 +414,122 @@ ShimVesaInformation(
 	BufferPtr += sizeof PRODUCT_REVISION;
 	
 	//
-	// Basic VESA mode information.
+	// VESA mode information, 256 bytes per mode.
 	//
-	VbeModeInfo = (VBE_MODE_INFO *)(VbeInfoFull + 1); // jump ahead by sizeof(VBE_INFO) ie. 256 bytes
+	if (sizeof INT10H_HANDLER + (NumModes - 1) * sizeof(VBE_MODE_INFO) > VGA_ROM_SIZE) {
+		PrintError(L"Information about %u video modes does not fit in VGA ROM, aborting\n", NumModes);
+		return EFI_BUFFER_TOO_SMALL;
+	}
+	for (Index = 0; Index < NumModes; Index++) {
+		if (Index == 0) {
+			VbeModeInfo = (VBE_MODE_INFO *)(VbeInfoFull + 1); // jump ahead by sizeof(VBE_INFO) ie. 256 bytes
+		} else {
+			VbeModeInfo = (VBE_MODE_INFO *)(UINTN)(StartAddress + sizeof INT10H_HANDLER) + (Index - 1);
+		}
+		Status = FillVesaModeInformation(VbeModeInfo, ModeWidth[Index], ModeHeight[Index]);
+		if (EFI_ERROR(Status)) {
+			return Status;
+		}
+		PrintDebug(L"VESA mode %03x is %ux%u\n", FIRST_VESA_MODE + Index, ModeWidth[Index], ModeHeight[Index]);
+	}
+
+	*EndAddress = StartAddress + sizeof(VBE_INFO) + sizeof(VBE_MODE_INFO);	// handler code follows
+	return EFI_SUCCESS;
+}
+
+
+/**
+  Adds a resolution to the list of VESA modes unless it is already
+  there, does not fit in the current display mode or the list is full.
+
+  @param[in,out] ModeWidth  Array of horizontal resolutions.
+  @param[in,out] ModeHeight Array of vertical resolutions.
+  @param[in,out] NumModes   Number of modes in the arrays.
+  @param[in] Width          Horizontal resolution to add.
+  @param[in] Height         Vertical resolution to add.
+
+**/
+VOID
+AddVesaMode(
+	IN OUT	UINT32				*ModeWidth,
+	IN OUT	UINT32				*ModeHeight,
+	IN OUT	UINTN				*NumModes,
+	IN		UINT32				Width,
+	IN		UINT32				Height)
+{
+	UINTN	Index;
+
+	if (*NumModes >= MAX_VESA_MODES
+		|| Width > DisplayInfo.HorizontalResolution
+		|| Height > DisplayInfo.VerticalResolution) {
+		return;
+	}
+	for (Index = 0; Index < *NumModes; Index++) {
+		if (ModeWidth[Index] == Width && ModeHeight[Index] == Height) {
+			return;
+		}
+	}
+	ModeWidth[*NumModes] = Width;
+	ModeHeight[*NumModes] = Height;
+	(*NumModes)++;
+}
+
+
+/**
+  Adds resolutions of all modes reported by the GOP display adapter
+  to the list of VESA modes.
+
+  @param[in,out] ModeWidth  Array of horizontal resolutions.
+  @param[in,out] ModeHeight Array of vertical resolutions.
+  @param[in,out] NumModes   Number of modes in the arrays.
+
+**/
+VOID
+CollectGopModes(
+	IN OUT	UINT32				*ModeWidth,
+	IN OUT	UINT32				*ModeHeight,
+	IN OUT	UINTN				*NumModes)
+{
+	EFI_STATUS								Status;
+	EFI_GRAPHICS_OUTPUT_MODE_INFORMATION	*Info;
+	UINTN									InfoSize;
+	UINT32									GopMode;
+
+	for (GopMode = 0; GopMode < DisplayInfo.GOP->Mode->MaxMode; GopMode++) {
+		Status = DisplayInfo.GOP->QueryMode(DisplayInfo.GOP, GopMode, &InfoSize, &Info);
+		if (EFI_ERROR(Status)) {
+			continue;
+		}
+		AddVesaMode(ModeWidth, ModeHeight, NumModes,
+			Info->HorizontalResolution, Info->VerticalResolution);
+		FreePool(Info);
+	}
+}
+
+
+/**
+  Fills in VESA mode information for a linear framebuffer mode
+  of the given resolution, centered on the screen of the current
+  display mode.
+
+  @param[out] VbeModeInfo Where to write the information.
+  @param[in] Width        Horizontal resolution of the mode.
+  @param[in] Height       Vertical resolution of the mode.
+
+  @retval EFI_SUCCESS     The operation was successful
+  @return other           The operation failed.
+
+**/
+EFI_STATUS
+FillVesaModeInformation(
+	OUT	VBE_MODE_INFO			*VbeModeInfo,
+	IN	UINT32					Width,
+	IN	UINT32					Height)
+{
+	UINT32					HorizontalOffsetPx;
+	UINT32					VerticalOffsetPx;
+	EFI_PHYSICAL_ADDRESS	FrameBufferBaseWithOffset;
+
 	// bit0: mode supported by present hardware configuration
 	// bit1: must be set for VBE v1.2+
 	// bit3: color mode
@@ -291,16 +542,16 @@ ShimVesaInformation(
 	//
 	// Resolution.
 	//
-	VbeModeInfo->Width = 1024;						// as expected by Windows installer
-	VbeModeInfo->Height = 768;						// as expected by Windows installer
+	VbeModeInfo->Width = (UINT16)Width;
+	VbeModeInfo->Height = (UINT16)Height;
 	VbeModeInfo->CharCellWidth = 8;					// used to calculate resolution in text modes
 	VbeModeInfo->CharCellHeight = 16;				// used to calculate resolution in text modes
 	
 	//
 	// Center visible image on screen using framebuffer offset.
 	//
-	HorizontalOffsetPx = (DisplayInfo.HorizontalResolution - 1024) / 2;
-	VerticalOffsetPx = (DisplayInfo.VerticalResolution - 768) / 2 * DisplayInfo.PixelsPerScanLine;
+	HorizontalOffsetPx = (DisplayInfo.HorizontalResolution - Width) / 2;
+	VerticalOffsetPx = (DisplayInfo.VerticalResolution - Height) / 2 * DisplayInfo.PixelsPerScanLine;
 	FrameBufferBaseWithOffset = DisplayInfo.FrameBufferBase 
 		+ VerticalOffsetPx * 4		// 4 bytes per pixel
 		+ HorizontalOffsetPx * 4;	// 4 bytes per pixel
@@ -359,7 +610,6 @@ ShimVesaInformation(
 	VbeModeInfo->MaxPixelClockHz = 0;				// maximum available refresh rate
 	VbeModeInfo->Vbe3 = 0x01;						// reserved, always set to 1
 
-	*EndAddress = (UINTN)(VbeModeInfo + 1);			// jump ahead by sizeof(VBE_MODE_INFO) ie. 256 bytes
 	return EFI_SUCCESS;
 }
 
@@ -565,15 +815,19 @@ ShowStaticLogo()
 	IMAGE		*WindowsFlag;
 
 	// Sanity checks.
-	Status = BmpFileToImage(BootflagSimple, sizeof BootflagSimple, (VOID **)&WindowsFlag);
+	TimingStart("LogoDecode");
+	Status = CompressedBmpToImage(BootflagSimple, (VOID **)&WindowsFlag);
+	TimingEnd("LogoDecode");
 	if (EFI_ERROR(Status)) {
 		return FALSE;
 	}
 	
 	// All fine, let's do some drawing.
+	TimingStart("LogoDraw");
 	SwtichToGraphics(FALSE);
 	ClearScreen();
 	DrawImageCentered(WindowsFlag);
+	TimingEnd("LogoDraw");
 
 	// Cleanup & return.
 	DestroyImage(WindowsFlag);
@@ -592,8 +846,11 @@ ShowStaticLogo()
   folder, and VgaShim.bmp is a valid, 24bpp bmp image file of
   size 200x10000, 50 frames will be shown (top to bottom).
 
-  @retval TRUE              Static logo was successfully retrieved
-                            and displayed on screen.
+  The animation plays in the background; FinishAnimatedLogo
+  has to be called before control is passed to another image.
+
+  @retval TRUE              Animated logo was successfully retrieved
+                            and started playing on screen.
   @retval FALSE             Either the required resource was not found
                             or was unable to switch to graphical output.
   
@@ -601,45 +858,78 @@ ShowStaticLogo()
 BOOLEAN
 ShowAnimatedLogo()
 {
-	EFI_STATUS	Status;
-	CHAR16		*BmpFilePath;
-	CHAR16		*MyFilePath;
-	UINT8		*BmpFileContents;
-	UINTN		BmpFileBytes;
-	IMAGE		*WindowsFlag = NULL;
+	EFI_STATUS		Status;
+	CHAR16			*BmpFilePath;
+	CHAR16			*MyFilePath;
+	EFI_FILE_HANDLE	BmpFile;
+	BMP_ANIMATION	*Animation;
 	
 	// Check if <MyName>.bmp exists
 	MyFilePath = PathCleanUpDirectories(ConvertDevicePathToText(VgaShimImageInfo->FilePath, FALSE, FALSE));
 	Status = ChangeExtension(MyFilePath, L"bmp", (VOID **)&BmpFilePath);
 	FreePool(MyFilePath);
-	if (EFI_ERROR(Status) || !FileExists(BmpFilePath)) {
-		FreePool(BmpFilePath);
+	if (EFI_ERROR(Status)) {
 		return FALSE;
 	}
 
-	// Read file contents.
-	Status = FileRead(BmpFilePath, (VOID **)&BmpFileContents, &BmpFileBytes);
+	// Open the file; frames will be read off the disk one by one.
+	Status = FileOpen(BmpFilePath, &BmpFile);
 	FreePool(BmpFilePath);
 	if (EFI_ERROR(Status)) {
 		return FALSE;
 	}
-	Status = BmpFileToImage(BmpFileContents, BmpFileBytes, (VOID **)&WindowsFlag);
-	FreePool(BmpFileContents);
+	TimingStart("LogoDecode");
+	Status = BmpAnimationOpen(BmpFile, &Animation);
+	TimingEnd("LogoDecode");
 	if (EFI_ERROR(Status)) {
+		BmpFile->Close(BmpFile);
 		return FALSE;
 	}
 
 	// All fine, let's do some drawing.
+	TimingStart("LogoDraw");
 	SwtichToGraphics(FALSE);
 	ClearScreen();
-	AnimateImage(WindowsFlag);
+	Status = BmpAnimationStart(Animation, MS_PER_FRAME);
+	TimingEnd("LogoDraw");
+	if (EFI_ERROR(Status)) {
+		BmpAnimationClose(Animation);
+		return FALSE;
+	}
 
-	// Cleanup & return.
-	DestroyImage(WindowsFlag);
+	LogoAnimation = Animation;
 	return TRUE;
 }
 
 
+/**
+  Ends the animated logo started by ShowAnimatedLogo, if any,
+  and releases all resources held by it.
+
+  @param[in] WaitForLastFrame TRUE to let the animation play
+                            till the end, FALSE to stop it
+                            straight away.
+
+**/
+VOID
+FinishAnimatedLogo(
+	IN	BOOLEAN	WaitForLastFrame)
+{
+	BMP_ANIMATION	*Animation;
+
+	if (LogoAnimation == NULL) {
+		return;
+	}
+
+	Animation = LogoAnimation;
+	LogoAnimation = NULL;
+	if (WaitForLastFrame) {
+		BmpAnimationWait(Animation);
+	}
+	BmpAnimationClose(Animation);
+}
+
+
 VOID
 EFIAPI
 PrintFuncNameMessage(
@@ -656,6 +946,13 @@ PrintFuncNameMessage(
 		return;
 	}
 
+	//
+	// Errors take precedence over the animated logo.
+	//
+	if (IsError) {
+		FinishAnimatedLogo(FALSE);
+	}
+
 	//
 	// Switch to text mode if needed.
 	//
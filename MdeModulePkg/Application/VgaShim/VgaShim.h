@@ -73,6 +73,10 @@ BOOLEAN
 ShowAnimatedLogo(
 	VOID);
 
+VOID
+FinishAnimatedLogo(
+	IN	BOOLEAN					WaitForLastFrame);
+
 BOOLEAN
 CanWriteAtAddress(
 	IN	EFI_PHYSICAL_ADDRESS	Address);
@@ -91,6 +95,34 @@ ShimVesaInformation(
 	IN	EFI_PHYSICAL_ADDRESS	StartAddress, 
 	OUT	EFI_PHYSICAL_ADDRESS	*EndAddress);
 
+VOID
+AddVesaMode(
+	IN OUT	UINT32				*ModeWidth,
+	IN OUT	UINT32				*ModeHeight,
+	IN OUT	UINTN				*NumModes,
+	IN		UINT32				Width,
+	IN		UINT32				Height);
+
+VOID
+CollectGopModes(
+	IN OUT	UINT32				*ModeWidth,
+	IN OUT	UINT32				*ModeHeight,
+	IN OUT	UINTN				*NumModes);
+
+EFI_STATUS
+FillVesaModeInformation(
+	OUT	VBE_MODE_INFO			*VbeModeInfo,
+	IN	UINT32					Width,
+	IN	UINT32					Height);
+
+VOID
+LoadBootManager(
+	OUT	EFI_HANDLE				*LaunchImage);
+
+VOID
+LogStage(
+	IN	CHAR16					*Stage);
+
 VOID
 WaitForEnter(
 	IN	BOOLEAN					PrintMessage);
@@ -112,6 +144,9 @@ STATIC CONST	EFI_PHYSICAL_ADDRESS	VGA_ROM_ADDRESS		= 0xc0000;
 STATIC CONST	EFI_PHYSICAL_ADDRESS	IVT_ADDRESS			= 0x00000;
 STATIC CONST	UINTN					VGA_ROM_SIZE		= 0x10000;
 STATIC CONST	UINTN					FIXED_MTRR_SIZE		= 0x20000;
+STATIC CONST	UINTN					MS_PER_FRAME		= 20;
+STATIC CONST	UINT16					FIRST_VESA_MODE		= 0x00f1;
+#define									MAX_VESA_MODES		16
 
 
 #endif
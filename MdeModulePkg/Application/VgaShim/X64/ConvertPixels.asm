@@ -0,0 +1,64 @@
+;------------------------------------------------------------------------------
+;
+; Copyright (c) 2016, Dawid Ciecierski
+;
+; This program and the accompanying materials
+; are licensed and made available under the terms and conditions of the BSD License
+; which accompanies this distribution.  The full text of the license may be found at
+; http://opensource.org/licenses/bsd-license.php.
+;
+; THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+; WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+;
+; Module Name:
+;
+;   ConvertPixels.asm
+;
+; Abstract:
+;
+;   SSSE3 conversion of 24bpp BGR pixels to 32bpp BGRx pixels
+;
+; Notes:
+;
+;   Four pixels (12 bytes) are converted per iteration with a single
+;   16-byte load, so the last two pixels are always left for the caller
+;   to make sure no bytes past the end of the source are read.
+;
+;------------------------------------------------------------------------------
+
+    .code
+
+;------------------------------------------------------------------------------
+;  UINTN
+;  EFIAPI
+;  InternalConvertBgr24ToBgra32Ssse3 (
+;    OUT VOID  *Target,
+;    IN  VOID  *Source,
+;    IN  UINTN NumPixels
+;    )
+;------------------------------------------------------------------------------
+InternalConvertBgr24ToBgra32Ssse3 PROC
+    xor     rax, rax
+    cmp     r8, 6
+    jb      @Done
+    mov     r9, 08005040380020100h      ; pixels 0 and 1, zero reserved byte
+    movq    xmm1, r9
+    mov     r9, 0800b0a0980080706h      ; pixels 2 and 3, zero reserved byte
+    movq    xmm2, r9
+    punpcklqdq xmm1, xmm2
+    sub     r8, 2
+@@:
+    movdqu  xmm0, [rdx]
+    pshufb  xmm0, xmm1
+    movdqu  [rcx], xmm0
+    add     rdx, 12
+    add     rcx, 16
+    add     rax, 4
+    lea     r9, [rax + 4]
+    cmp     r9, r8
+    jbe     @B
+@Done:
+    ret
+InternalConvertBgr24ToBgra32Ssse3 ENDP
+
+    END
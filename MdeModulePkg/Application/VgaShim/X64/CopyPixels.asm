@@ -0,0 +1,60 @@
+;------------------------------------------------------------------------------
+;
+; Copyright (c) 2016, Dawid Ciecierski
+;
+; This program and the accompanying materials
+; are licensed and made available under the terms and conditions of the BSD License
+; which accompanies this distribution.  The full text of the license may be found at
+; http://opensource.org/licenses/bsd-license.php.
+;
+; THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+; WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+;
+; Module Name:
+;
+;   CopyPixels.asm
+;
+; Abstract:
+;
+;   Copy of 32bpp pixels into video memory with non-temporal stores
+;
+; Notes:
+;
+;   Non-temporal stores bypass the cache, so copying a frame to video memory
+;   does not evict the decoder working set.
+;
+;------------------------------------------------------------------------------
+
+    .code
+
+;------------------------------------------------------------------------------
+;  VOID
+;  EFIAPI
+;  InternalCopyPixelsNonTemporal (
+;    OUT VOID  *Target,
+;    IN  VOID  *Source,
+;    IN  UINTN NumPixels
+;    )
+;------------------------------------------------------------------------------
+InternalCopyPixelsNonTemporal PROC
+    mov     r9, r8
+    shr     r9, 1                       ; pixel pairs
+    jz      @Single
+@@:
+    mov     rax, [rdx]
+    movnti  [rcx], rax
+    add     rdx, 8
+    add     rcx, 8
+    dec     r9
+    jnz     @B
+@Single:
+    test    r8, 1
+    jz      @Fence
+    mov     eax, [rdx]
+    movnti  [rcx], eax
+@Fence:
+    sfence
+    ret
+InternalCopyPixelsNonTemporal ENDP
+
+    END
@@ -25,6 +25,63 @@ BOOLEAN *mDepexEvaluationStack        = NULL;
 BOOLEAN *mDepexEvaluationStackEnd     = NULL;
 BOOLEAN *mDepexEvaluationStackPointer = NULL;
 
+//
+// Dependency graph.  Every protocol GUID that a depex was found waiting on has a
+// DEPEX_PROTOCOL_NODE, with a DEPEX_PROTOCOL_EDGE to each driver waiting on it.
+// Installing the protocol signals the node, and only the drivers on its edges
+// have their depex evaluated again.
+//
+#define DEPEX_PROTOCOL_NODE_SIGNATURE  SIGNATURE_32('d','p','n','d')
+#define DEPEX_PROTOCOL_EDGE_SIGNATURE  SIGNATURE_32('d','p','e','g')
+#define DEPEX_PROTOCOL_HASH_SIZE       64
+
+typedef struct {
+  UINTN                   Signature;
+  LIST_ENTRY              Link;           // mDepexProtocolHash[]
+  LIST_ENTRY              PendingLink;    // mDepexPendingProtocolList
+  EFI_GUID                ProtocolGuid;
+  LIST_ENTRY              EdgeList;       // DEPEX_PROTOCOL_EDGE
+  EFI_EVENT               Event;
+  VOID                    *Registration;
+  BOOLEAN                 Pending;
+} DEPEX_PROTOCOL_NODE;
+
+typedef struct {
+  UINTN                   Signature;
+  LIST_ENTRY              Link;           // DEPEX_PROTOCOL_NODE.EdgeList
+  EFI_CORE_DRIVER_ENTRY   *DriverEntry;
+  UINT8                   *Opcode;        // EFI_DEP_PUSH of the protocol in the depex
+} DEPEX_PROTOCOL_EDGE;
+
+LIST_ENTRY           mDepexProtocolHash[DEPEX_PROTOCOL_HASH_SIZE];
+BOOLEAN              mDepexProtocolHashInitialized = FALSE;
+LIST_ENTRY           mDepexPendingProtocolList = INITIALIZE_LIST_HEAD_VARIABLE (mDepexPendingProtocolList);
+
+//
+// Drivers without a depex wait on all the architectural protocols, which this
+// node stands for.  It is signaled by the dispatcher rather than by an event.
+//
+DEPEX_PROTOCOL_NODE  mDepexArchProtocolNode = {
+  DEPEX_PROTOCOL_NODE_SIGNATURE,
+  { NULL, NULL },
+  { NULL, NULL },
+  { 0 },
+  INITIALIZE_LIST_HEAD_VARIABLE (mDepexArchProtocolNode.EdgeList),
+  NULL,
+  NULL,
+  FALSE
+};
+
+//
+// Drivers whose depex has to be evaluated on the next pass, in discovery order
+//
+LIST_ENTRY           mDepexEvaluationQueue = INITIALIZE_LIST_HEAD_VARIABLE (mDepexEvaluationQueue);
+
+//
+// Lock for mDepexPendingProtocolList and mDepexEvaluationQueue
+//
+EFI_LOCK             mDepexGraphLock = EFI_INITIALIZE_LOCK_VARIABLE (TPL_HIGH_LEVEL);
+
 //
 // Worker functions
 //
@@ -440,3 +497,405 @@ Done:
 }
 
 
+
+/**
+  Notification function of the events registered for the protocols in the
+  dependency graph.  Marks the node so that the dispatcher looks at the
+  drivers waiting on the protocol on its next pass.
+
+  @param  Event                 The event that was signaled.
+  @param  Context               The DEPEX_PROTOCOL_NODE of the protocol.
+
+**/
+VOID
+EFIAPI
+CoreDepexProtocolNotify (
+  IN EFI_EVENT                Event,
+  IN VOID                     *Context
+  )
+{
+  DEPEX_PROTOCOL_NODE  *Node;
+
+  Node = (DEPEX_PROTOCOL_NODE *)Context;
+
+  CoreAcquireLock (&mDepexGraphLock);
+  if (!Node->Pending) {
+    Node->Pending = TRUE;
+    InsertTailList (&mDepexPendingProtocolList, &Node->PendingLink);
+  }
+  CoreReleaseLock (&mDepexGraphLock);
+}
+
+
+
+/**
+  Find the node of a protocol in the dependency graph, and add it if it is
+  not there yet.
+
+  @param  ProtocolGuid          The protocol to look up.
+
+  @return The node of the protocol, or NULL if it could not be added.
+
+**/
+DEPEX_PROTOCOL_NODE *
+CoreGetDepexProtocolNode (
+  IN  EFI_GUID                *ProtocolGuid
+  )
+{
+  EFI_STATUS           Status;
+  LIST_ENTRY           *Bucket;
+  LIST_ENTRY           *Link;
+  DEPEX_PROTOCOL_NODE  *Node;
+  VOID                 *Interface;
+  UINTN                Index;
+
+  if (!mDepexProtocolHashInitialized) {
+    for (Index = 0; Index < DEPEX_PROTOCOL_HASH_SIZE; Index++) {
+      InitializeListHead (&mDepexProtocolHash[Index]);
+    }
+    mDepexProtocolHashInitialized = TRUE;
+  }
+
+  Bucket = &mDepexProtocolHash[(ReadUnaligned32 ((UINT32 *)ProtocolGuid) ^ ReadUnaligned32 ((UINT32 *)ProtocolGuid + 3)) % DEPEX_PROTOCOL_HASH_SIZE];
+  for (Link = Bucket->ForwardLink; Link != Bucket; Link = Link->ForwardLink) {
+    Node = CR (Link, DEPEX_PROTOCOL_NODE, Link, DEPEX_PROTOCOL_NODE_SIGNATURE);
+    if (CompareGuid (&Node->ProtocolGuid, ProtocolGuid)) {
+      return Node;
+    }
+  }
+
+  Node = AllocateZeroPool (sizeof (DEPEX_PROTOCOL_NODE));
+  if (Node == NULL) {
+    return NULL;
+  }
+  Node->Signature = DEPEX_PROTOCOL_NODE_SIGNATURE;
+  CopyGuid (&Node->ProtocolGuid, ProtocolGuid);
+  InitializeListHead (&Node->EdgeList);
+
+  Status = CoreCreateEvent (
+             EVT_NOTIFY_SIGNAL,
+             TPL_CALLBACK,
+             CoreDepexProtocolNotify,
+             Node,
+             &Node->Event
+             );
+  if (!EFI_ERROR (Status)) {
+    Status = CoreRegisterProtocolNotify (&Node->ProtocolGuid, Node->Event, &Node->Registration);
+    if (EFI_ERROR (Status)) {
+      CoreCloseEvent (Node->Event);
+    }
+  }
+  if (EFI_ERROR (Status)) {
+    FreePool (Node);
+    return NULL;
+  }
+
+  InsertTailList (Bucket, &Node->Link);
+
+  //
+  // The protocol may have been installed since the depex was evaluated, and
+  // the event only reports later installations
+  //
+  if (!EFI_ERROR (CoreLocateProtocol (&Node->ProtocolGuid, NULL, &Interface))) {
+    CoreDepexProtocolNotify (Node->Event, Node);
+  }
+
+  return Node;
+}
+
+
+
+/**
+  Add an edge from a node of the dependency graph to a driver waiting on it.
+
+  @param  Node                  The node of the protocol the driver waits on.
+  @param  DriverEntry           The driver.
+  @param  Opcode                The push of the protocol in the depex of the
+                                driver, or NULL.
+
+  @retval EFI_SUCCESS           The edge was added.
+  @retval EFI_OUT_OF_RESOURCES  There is not enough memory to add the edge.
+
+**/
+EFI_STATUS
+CoreAddDepexProtocolEdge (
+  IN  DEPEX_PROTOCOL_NODE     *Node,
+  IN  EFI_CORE_DRIVER_ENTRY   *DriverEntry,
+  IN  UINT8                   *Opcode
+  )
+{
+  DEPEX_PROTOCOL_EDGE  *Edge;
+
+  if (Node == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Edge = AllocateZeroPool (sizeof (DEPEX_PROTOCOL_EDGE));
+  if (Edge == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+  Edge->Signature   = DEPEX_PROTOCOL_EDGE_SIGNATURE;
+  Edge->DriverEntry = DriverEntry;
+  Edge->Opcode      = Opcode;
+  InsertTailList (&Node->EdgeList, &Edge->Link);
+
+  if (Opcode != NULL) {
+    DriverEntry->DepexUnmetCount++;
+  }
+  return EFI_SUCCESS;
+}
+
+
+
+/**
+  Add a driver whose depex just evaluated to FALSE to the dependency graph,
+  so that its depex is only evaluated again once one of the protocols it is
+  waiting on has been installed.
+
+  Every protocol still pushed by the depex is missing, as CoreIsSchedulable()
+  replaces the pushes of installed protocols by EFI_DEP_REPLACE_TRUE.  If the
+  depex only ANDs protocols together, the driver cannot be scheduled before
+  all of them were installed, so it is not evaluated again before then.  Any
+  other depex is evaluated again each time one of its protocols is installed.
+
+  @param  DriverEntry           DriverEntry element to add.
+
+  @retval EFI_SUCCESS           The driver was added, or did not need to be.
+  @retval EFI_OUT_OF_RESOURCES  There is not enough memory to track the driver.
+
+**/
+EFI_STATUS
+CoreBuildDepexGraph (
+  IN  EFI_CORE_DRIVER_ENTRY   *DriverEntry
+  )
+{
+  EFI_STATUS  Status;
+  UINT8       *Iterator;
+  EFI_GUID    DriverGuid;
+  UINTN       Depth;
+
+  if (DriverEntry->DepexGraphBuilt || DriverEntry->Before || DriverEntry->After) {
+    //
+    // Before and After drivers are scheduled along with the driver they refer to
+    //
+    return EFI_SUCCESS;
+  }
+
+  DriverEntry->DepexGraphBuilt = TRUE;
+  DriverEntry->DepexAndOnly    = FALSE;
+  DriverEntry->DepexUnmetCount = 0;
+
+  if (DriverEntry->Depex == NULL) {
+    DEBUG ((DEBUG_DISPATCH, "  FFS(%g) waits on the architectural protocols\n", &DriverEntry->FileName));
+    return CoreAddDepexProtocolEdge (&mDepexArchProtocolNode, DriverEntry, NULL);
+  }
+
+  Status   = EFI_SUCCESS;
+  Depth    = 0;
+  Iterator = DriverEntry->Depex;
+  DriverEntry->DepexAndOnly = TRUE;
+  while (((UINTN)Iterator - (UINTN)DriverEntry->Depex) < DriverEntry->DepexSize) {
+    if (*Iterator == EFI_DEP_PUSH || *Iterator == EFI_DEP_REPLACE_TRUE) {
+      if (((UINTN)Iterator - (UINTN)DriverEntry->Depex) + 1 + sizeof (EFI_GUID) > DriverEntry->DepexSize) {
+        break;
+      }
+      if (*Iterator == EFI_DEP_PUSH) {
+        CopyMem (&DriverGuid, Iterator + 1, sizeof (EFI_GUID));
+        Status = CoreAddDepexProtocolEdge (CoreGetDepexProtocolNode (&DriverGuid), DriverEntry, Iterator);
+        if (EFI_ERROR (Status)) {
+          return Status;
+        }
+      }
+      Depth++;
+      Iterator += sizeof (EFI_GUID);
+    } else if (*Iterator == EFI_DEP_TRUE) {
+      Depth++;
+    } else if (*Iterator == EFI_DEP_AND && Depth >= 2) {
+      Depth--;
+    } else if (*Iterator == EFI_DEP_SOR && Iterator == DriverEntry->Depex) {
+      //
+      // SOR is a NOP as the first opcode
+      //
+    } else if (*Iterator == EFI_DEP_END) {
+      break;
+    } else if (*Iterator == EFI_DEP_AND || *Iterator == EFI_DEP_OR || *Iterator == EFI_DEP_NOT || *Iterator == EFI_DEP_FALSE) {
+      DriverEntry->DepexAndOnly = FALSE;
+    } else {
+      //
+      // The depex is malformed, so it never evaluates to TRUE
+      //
+      break;
+    }
+    Iterator++;
+  }
+
+  if (((UINTN)Iterator - (UINTN)DriverEntry->Depex) >= DriverEntry->DepexSize || *Iterator != EFI_DEP_END ||
+      Depth != 1 || DriverEntry->DepexUnmetCount == 0) {
+    DriverEntry->DepexAndOnly = FALSE;
+  }
+
+  DEBUG ((
+    DEBUG_DISPATCH,
+    "  FFS(%g) waits on %d protocol(s)%a\n",
+    &DriverEntry->FileName,
+    DriverEntry->DepexUnmetCount,
+    DriverEntry->DepexAndOnly ? "" : ", evaluated again on each"
+    ));
+
+  return Status;
+}
+
+
+
+/**
+  Queue a driver for its depex to be evaluated on the next dispatcher pass.
+  Queued drivers are evaluated in the order they were discovered.
+
+  @param  DriverEntry           DriverEntry element to queue.
+
+**/
+VOID
+CoreQueueDepexEvaluation (
+  IN  EFI_CORE_DRIVER_ENTRY   *DriverEntry
+  )
+{
+  LIST_ENTRY             *Link;
+  EFI_CORE_DRIVER_ENTRY  *QueuedEntry;
+
+  CoreAcquireLock (&mDepexGraphLock);
+
+  if (!DriverEntry->DepexQueued) {
+    //
+    // Drivers are mostly queued in discovery order, so look from the tail
+    //
+    for (Link = mDepexEvaluationQueue.BackLink; Link != &mDepexEvaluationQueue; Link = Link->BackLink) {
+      QueuedEntry = CR (Link, EFI_CORE_DRIVER_ENTRY, EvaluationLink, EFI_CORE_DRIVER_ENTRY_SIGNATURE);
+      if (QueuedEntry->DiscoveryIndex < DriverEntry->DiscoveryIndex) {
+        break;
+      }
+    }
+    InsertHeadList (Link, &DriverEntry->EvaluationLink);
+    DriverEntry->DepexQueued = TRUE;
+  }
+
+  CoreReleaseLock (&mDepexGraphLock);
+}
+
+
+
+/**
+  Queue the drivers waiting on a protocol of the dependency graph that has
+  been installed.  Edges to drivers that are no longer waiting are removed.
+
+  If the protocol is still installed, its pushes are replaced by
+  EFI_DEP_REPLACE_TRUE, as CoreIsSchedulable() would have done had it
+  evaluated the depex on this pass.  This keeps the outcome of every depex
+  the same as when all of them are evaluated on every pass.
+
+  @param  Node                  The node of the protocol.
+  @param  Installed             TRUE if the protocol is installed.
+
+**/
+VOID
+CoreQueueDepexProtocolEdges (
+  IN  DEPEX_PROTOCOL_NODE     *Node,
+  IN  BOOLEAN                 Installed
+  )
+{
+  LIST_ENTRY             *Link;
+  DEPEX_PROTOCOL_EDGE    *Edge;
+  EFI_CORE_DRIVER_ENTRY  *DriverEntry;
+
+  for (Link = Node->EdgeList.ForwardLink; Link != &Node->EdgeList; ) {
+    Edge        = CR (Link, DEPEX_PROTOCOL_EDGE, Link, DEPEX_PROTOCOL_EDGE_SIGNATURE);
+    DriverEntry = Edge->DriverEntry;
+    Link        = Link->ForwardLink;
+
+    //
+    // Once a driver leaves the Dependent state it never goes back to it
+    //
+    if (!DriverEntry->Dependent) {
+      RemoveEntryList (&Edge->Link);
+      FreePool (Edge);
+      continue;
+    }
+
+    if (Installed && Edge->Opcode != NULL && *Edge->Opcode == EFI_DEP_PUSH) {
+      *Edge->Opcode = EFI_DEP_REPLACE_TRUE;
+      DriverEntry->DepexUnmetCount--;
+    }
+
+    if (!DriverEntry->DepexAndOnly || DriverEntry->DepexUnmetCount == 0) {
+      DEBUG ((DEBUG_DISPATCH, "  FFS(%g) queued\n", &DriverEntry->FileName));
+      CoreQueueDepexEvaluation (DriverEntry);
+    } else {
+      DEBUG ((DEBUG_DISPATCH, "  FFS(%g) still waits on %d protocol(s)\n", &DriverEntry->FileName, DriverEntry->DepexUnmetCount));
+    }
+  }
+}
+
+
+
+/**
+  Queue the drivers waiting on the protocols installed since the last
+  dispatcher pass.
+
+**/
+VOID
+CoreQueuePendingDepexEvaluations (
+  VOID
+  )
+{
+  DEPEX_PROTOCOL_NODE  *Node;
+  VOID                 *Interface;
+
+  if (!IsListEmpty (&mDepexArchProtocolNode.EdgeList) && !EFI_ERROR (CoreAllEfiServicesAvailable ())) {
+    DEBUG ((DEBUG_DISPATCH, "All UEFI Services Available\n"));
+    CoreQueueDepexProtocolEdges (&mDepexArchProtocolNode, TRUE);
+  }
+
+  CoreAcquireLock (&mDepexGraphLock);
+  while (!IsListEmpty (&mDepexPendingProtocolList)) {
+    Node = CR (mDepexPendingProtocolList.ForwardLink, DEPEX_PROTOCOL_NODE, PendingLink, DEPEX_PROTOCOL_NODE_SIGNATURE);
+    RemoveEntryList (&Node->PendingLink);
+    Node->Pending = FALSE;
+    CoreReleaseLock (&mDepexGraphLock);
+
+    DEBUG ((DEBUG_DISPATCH, "Protocol GUID(%g) installed\n", &Node->ProtocolGuid));
+    CoreQueueDepexProtocolEdges (
+      Node,
+      (BOOLEAN)!EFI_ERROR (CoreLocateProtocol (&Node->ProtocolGuid, NULL, &Interface))
+      );
+
+    CoreAcquireLock (&mDepexGraphLock);
+  }
+  CoreReleaseLock (&mDepexGraphLock);
+}
+
+
+
+/**
+  Remove the first driver from the depex evaluation queue.
+
+  @return The driver, or NULL if the queue is empty.
+
+**/
+EFI_CORE_DRIVER_ENTRY *
+CoreGetNextDepexEvaluation (
+  VOID
+  )
+{
+  EFI_CORE_DRIVER_ENTRY  *DriverEntry;
+
+  DriverEntry = NULL;
+
+  CoreAcquireLock (&mDepexGraphLock);
+  if (!IsListEmpty (&mDepexEvaluationQueue)) {
+    DriverEntry = CR (mDepexEvaluationQueue.ForwardLink, EFI_CORE_DRIVER_ENTRY, EvaluationLink, EFI_CORE_DRIVER_ENTRY_SIGNATURE);
+    RemoveEntryList (&DriverEntry->EvaluationLink);
+    DriverEntry->DepexQueued = FALSE;
+  }
+  CoreReleaseLock (&mDepexGraphLock);
+
+  return DriverEntry;
+}
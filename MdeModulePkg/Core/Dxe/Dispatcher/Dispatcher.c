@@ -67,6 +67,22 @@ EFI_LOCK  mDispatcherLock = EFI_INITIALIZE_LOCK_VARIABLE (TPL_HIGH_LEVEL);
 //
 BOOLEAN  gDispatcherRunning = FALSE;
 
+//
+// Number of drivers added to mDiscoveredList so far.
+//
+UINTN    mDiscoveredCount = 0;
+
+//
+// Number of drivers whose Depex could not be read yet and has to be read again.
+//
+UINTN    mDepexProtocolErrorCount = 0;
+
+//
+// TRUE if some driver could not be added to the dependency graph. The Depex of
+// every Dependent driver is then evaluated on every pass.
+//
+BOOLEAN  mDepexFullScan = FALSE;
+
 //
 // Module globals to manage the FwVol registration notification event
 //
@@ -272,14 +288,17 @@ CoreGetDepexSectionAndPreProccess (
       //
       // The section extraction protocol failed so set protocol error flag
       //
+      if (!DriverEntry->DepexProtocolError) {
+        mDepexProtocolErrorCount++;
+      }
       DriverEntry->DepexProtocolError = TRUE;
+      return Status;
     } else {
       //
       // If no Depex assume UEFI 2.0 driver model
       //
       DriverEntry->Depex = NULL;
       DriverEntry->Dependent = TRUE;
-      DriverEntry->DepexProtocolError = FALSE;
     }
   } else {
     //
@@ -287,9 +306,13 @@ CoreGetDepexSectionAndPreProccess (
     // Driver will be put in Dependent or Unrequested state
     //
     CorePreProcessDepex (DriverEntry);
-    DriverEntry->DepexProtocolError = FALSE;
   }
 
+  if (DriverEntry->DepexProtocolError) {
+    mDepexProtocolErrorCount--;
+  }
+  DriverEntry->DepexProtocolError = FALSE;
+
   return Status;
 }
 
@@ -334,6 +357,8 @@ CoreSchedule (
       DriverEntry->Dependent    = TRUE;
       CoreReleaseDispatcherLock ();
 
+      CoreQueueDepexEvaluation (DriverEntry);
+
       DEBUG ((DEBUG_DISPATCH, "Schedule FFS(%g) - EFI_SUCCESS\n", DriverName));
       
       return EFI_SUCCESS;
@@ -568,12 +593,27 @@ CoreDispatcher (
     }
 
     //
-    // Search DriverList for items to place on Scheduled Queue
+    // Queue the drivers whose Depex may evaluate differently since the last pass:
+    // drivers discovered or requested since then, drivers waiting on a protocol
+    // that has been installed since then, and drivers whose Depex has to be read
+    // again. The Depex of the other drivers still evaluates to FALSE.
     //
-    ReadyToRun = FALSE;
-    for (Link = mDiscoveredList.ForwardLink; Link != &mDiscoveredList; Link = Link->ForwardLink) {
-      DriverEntry = CR (Link, EFI_CORE_DRIVER_ENTRY, Link, EFI_CORE_DRIVER_ENTRY_SIGNATURE);
+    CoreQueuePendingDepexEvaluations ();
+    if (mDepexProtocolErrorCount != 0 || mDepexFullScan) {
+      for (Link = mDiscoveredList.ForwardLink; Link != &mDiscoveredList; Link = Link->ForwardLink) {
+        DriverEntry = CR (Link, EFI_CORE_DRIVER_ENTRY, Link, EFI_CORE_DRIVER_ENTRY_SIGNATURE);
+        if (DriverEntry->DepexProtocolError || (mDepexFullScan && DriverEntry->Dependent)) {
+          CoreQueueDepexEvaluation (DriverEntry);
+        }
+      }
+    }
 
+    //
+    // Evaluate the queued drivers in the order they were discovered, and place
+    // those that are ready on the Scheduled Queue
+    //
+    ReadyToRun = FALSE;
+    while ((DriverEntry = CoreGetNextDepexEvaluation ()) != NULL) {
       if (DriverEntry->DepexProtocolError){
         //
         // If Section Extraction Protocol did not let the Depex be read before retry the read
@@ -585,6 +625,9 @@ CoreDispatcher (
         if (CoreIsSchedulable (DriverEntry)) {
           CoreInsertOnScheduledQueueWhileProcessingBeforeAndAfter (DriverEntry);
           ReadyToRun = TRUE;
+        } else if (EFI_ERROR (CoreBuildDepexGraph (DriverEntry))) {
+          DEBUG ((DEBUG_DISPATCH, "  FFS(%g) not tracked, evaluating every Depex on every pass\n", &DriverEntry->FileName));
+          mDepexFullScan = TRUE;
         }
       } else {
         if (DriverEntry->Unrequested) {
@@ -913,10 +956,18 @@ CoreAddToDriverList (
 
   CoreAcquireDispatcherLock ();
 
+  DriverEntry->DiscoveryIndex = mDiscoveredCount++;
   InsertTailList (&mDiscoveredList, &DriverEntry->Link);
 
   CoreReleaseDispatcherLock ();
 
+  //
+  // Evaluate the Depex of the new driver on the next pass
+  //
+  if (DriverEntry->Dependent) {
+    CoreQueueDepexEvaluation (DriverEntry);
+  }
+
   return EFI_SUCCESS;
 }
 
@@ -199,6 +199,13 @@ typedef struct {
   EFI_HANDLE                      ImageHandle;
   BOOLEAN                         IsFvImage;
 
+  UINTN                           DiscoveryIndex;   // Position in mDiscoveredList
+  LIST_ENTRY                      EvaluationLink;   // mDepexEvaluationQueue
+  BOOLEAN                         DepexQueued;
+  BOOLEAN                         DepexGraphBuilt;
+  BOOLEAN                         DepexAndOnly;
+  UINTN                           DepexUnmetCount;
+
 } EFI_CORE_DRIVER_ENTRY;
 
 //
@@ -531,6 +538,59 @@ CorePreProcessDepex (
   );
 
 
+/**
+  Add a driver whose depex just evaluated to FALSE to the dependency graph,
+  so that its depex is only evaluated again once one of the protocols it is
+  waiting on has been installed.
+
+  @param  DriverEntry           DriverEntry element to add.
+
+  @retval EFI_SUCCESS           The driver was added, or did not need to be.
+  @retval EFI_OUT_OF_RESOURCES  There is not enough memory to track the driver.
+
+**/
+EFI_STATUS
+CoreBuildDepexGraph (
+  IN  EFI_CORE_DRIVER_ENTRY   *DriverEntry
+  );
+
+
+/**
+  Queue a driver for its depex to be evaluated on the next dispatcher pass.
+  Queued drivers are evaluated in the order they were discovered.
+
+  @param  DriverEntry           DriverEntry element to queue.
+
+**/
+VOID
+CoreQueueDepexEvaluation (
+  IN  EFI_CORE_DRIVER_ENTRY   *DriverEntry
+  );
+
+
+/**
+  Queue the drivers waiting on the protocols installed since the last
+  dispatcher pass.
+
+**/
+VOID
+CoreQueuePendingDepexEvaluations (
+  VOID
+  );
+
+
+/**
+  Remove the first driver from the depex evaluation queue.
+
+  @return The driver, or NULL if the queue is empty.
+
+**/
+EFI_CORE_DRIVER_ENTRY *
+CoreGetNextDepexEvaluation (
+  VOID
+  );
+
+
 
 /**
   Terminates all boot services.
@@ -2225,6 +2285,75 @@ CoreDisplayDiscoveredNotDispatched (
   );
 
 
+/**
+  Displays the usage statistics of one of the DXE Core services.  Only used
+  in Debug Builds.
+
+**/
+typedef
+VOID
+(*CORE_DISPLAY_STATISTICS) (
+  VOID
+  );
+
+
+/**
+  Displays how many protocol entry lookups were done and how many GUID
+  compares they took.  Only used in Debug Builds.
+
+**/
+VOID
+CoreDisplayProtocolDatabaseStatistics (
+  VOID
+  );
+
+
+/**
+  Displays how many timers were queued and how many trigger time compares
+  it took to keep them in order.  Only used in Debug Builds.
+
+**/
+VOID
+CoreDisplayTimerStatistics (
+  VOID
+  );
+
+
+/**
+  Displays how many files were looked up by name, how many file name
+  compares the index saved, and how many bytes of section stream the section
+  offset cache did not have to walk.  Only used in Debug Builds.
+
+**/
+VOID
+CoreDisplayFwVolStatistics (
+  VOID
+  );
+
+
+/**
+  Displays how many encapsulation sections were found in the cache of
+  decompressed sections, how many were not, and how many decompressed bytes
+  the cache provided.  Only used in Debug Builds.
+
+**/
+VOID
+CoreDisplaySectionCacheStatistics (
+  VOID
+  );
+
+
+/**
+  Displays how many driver binding Supported() calls ConnectController() made
+  and how many it skipped.  Only used in Debug Builds.
+
+**/
+VOID
+CoreDisplayDriverBindingStatistics (
+  VOID
+  );
+
+
 /**
   Place holder function until all the Boot Services and Runtime Services are
   available.
@@ -2883,6 +3012,15 @@ CoreUpdateMemoryAttributes (
   IN UINT64                NewAttributes
   );
 
+/**
+  Initialize the memory map snapshot support.
+
+**/
+VOID
+CoreInitializeMemoryMapSnapshot (
+  VOID
+  );
+
 /**
   Initialize PropertiesTable support.
 **/
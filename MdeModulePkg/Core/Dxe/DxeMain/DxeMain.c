@@ -222,6 +222,42 @@ EFI_DECOMPRESS_PROTOCOL  gEfiDecompress = {
 //
 GLOBAL_REMOVE_IF_UNREFERENCED EFI_LOAD_FIXED_ADDRESS_CONFIGURATION_TABLE    gLoadModuleAtFixAddressConfigurationTable = {0, 0};
 
+//
+// The usage statistics of the DXE Core services, displayed once when the
+// platform is ready to boot in Debug Builds
+//
+GLOBAL_REMOVE_IF_UNREFERENCED CORE_DISPLAY_STATISTICS  mCoreDisplayStatistics[] = {
+  CoreDisplayProtocolDatabaseStatistics,
+  CoreDisplayTimerStatistics,
+  CoreDisplayFwVolStatistics,
+  CoreDisplaySectionCacheStatistics,
+  CoreDisplayDriverBindingStatistics
+};
+
+/**
+  Displays the usage statistics of the DXE Core services, once, when the
+  platform is ready to boot.  Most of the controllers are connected by BDS,
+  so the statistics cover BDS too.  Only used in Debug Builds.
+
+  @param  Event                  The Event that is being processed.
+  @param  Context                The Event Context.
+
+**/
+VOID
+EFIAPI
+CoreDisplayStatisticsOnReadyToBoot (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < sizeof (mCoreDisplayStatistics) / sizeof (mCoreDisplayStatistics[0]); Index++) {
+    mCoreDisplayStatistics[Index] ();
+  }
+  CoreCloseEvent (Event);
+}
+
 // Main entry point to the DXE Core
 //
 
@@ -248,6 +284,7 @@ DxeMain (
   EFI_VECTOR_HANDOFF_INFO       *VectorInfoList;
   EFI_VECTOR_HANDOFF_INFO       *VectorInfo;
   VOID                          *EntryPoint;
+  EFI_EVENT                     ReadyToBootEvent;
 
   //
   // Setup the default exception handlers
@@ -393,6 +430,7 @@ DxeMain (
 
   MemoryProfileInstallProtocol ();
 
+  CoreInitializeMemoryMapSnapshot ();
   CoreInitializePropertiesTable ();
   CoreInitializeMemoryAttributesTable ();
 
@@ -488,6 +526,21 @@ DxeMain (
     CoreDisplayDiscoveredNotDispatched ();
   DEBUG_CODE_END ();
 
+  //
+  // Display the usage statistics of the DXE Core services when the platform
+  // is ready to boot if this is a debug build
+  //
+  DEBUG_CODE_BEGIN ();
+    CoreCreateEventEx (
+      EVT_NOTIFY_SIGNAL,
+      TPL_CALLBACK,
+      CoreDisplayStatisticsOnReadyToBoot,
+      NULL,
+      &gEfiEventReadyToBootGuid,
+      &ReadyToBootEvent
+      );
+  DEBUG_CODE_END ();
+
   //
   // Assert if the Architectural Protocols are not present.
   //
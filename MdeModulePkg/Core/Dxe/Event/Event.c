@@ -470,6 +470,17 @@ CoreCreateEventInternal (
     return EFI_OUT_OF_RESOURCES;
   }
 
+  //
+  // Make sure the timer can always be queued
+  //
+  if ((Type & EVT_TIMER) != 0) {
+    Status = CoreReserveTimerEvent ();
+    if (EFI_ERROR (Status)) {
+      CoreFreePool (IEvent);
+      return Status;
+    }
+  }
+
   IEvent->Signature = EVENT_SIGNATURE;
   IEvent->Type = Type;
 
@@ -740,6 +751,7 @@ CoreCloseEvent (
   //
   if ((Event->Type & EVT_TIMER) != 0) {
     CoreSetTimer (Event, TimerCancel, 0);
+    CoreReleaseTimerEvent ();
   }
 
   CoreAcquireEventLock ();
@@ -29,6 +29,11 @@ extern  UINTN                   gEventPending;
 ///
 #define EVT_EXFLAG_EVENT_PROTOCOL_NOTIFICATION    0x02
 
+///
+/// Number of entries the timer heap starts with
+///
+#define TIMER_HEAP_INITIAL_SIZE   32
+
 //
 // EFI_EVENT
 //
@@ -37,7 +42,10 @@ extern  UINTN                   gEventPending;
 /// Timer event information
 ///
 typedef struct {
-  LIST_ENTRY      Link;
+  /// Position of the event in the timer heap plus one, 0 if the timer is not queued
+  UINTN           HeapIndex;
+  /// Order in which the timer was queued, breaks ties between equal trigger times
+  UINT64          Sequence;
   UINT64          TriggerTime;
   UINT64          Period;
 } TIMER_EVENT_INFO;
@@ -94,4 +102,29 @@ CoreInitializeTimer (
   VOID
   );
 
+
+/**
+  Reserves an entry in the timer heap for a new timer event, growing the
+  heap if needed.
+
+  @retval EFI_SUCCESS            The entry was reserved
+  @retval EFI_OUT_OF_RESOURCES   The heap could not be grown
+
+**/
+EFI_STATUS
+CoreReserveTimerEvent (
+  VOID
+  );
+
+
+/**
+  Gives back the timer heap entry of a timer event that is being closed.
+  The timer must not be queued.
+
+**/
+VOID
+CoreReleaseTimerEvent (
+  VOID
+  );
+
 #endif
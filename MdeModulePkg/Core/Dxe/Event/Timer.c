@@ -20,16 +20,197 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 // Internal data
 //
 
-LIST_ENTRY       mEfiTimerList = INITIALIZE_LIST_HEAD_VARIABLE (mEfiTimerList);
+//
+// mEfiTimerHeap         - Binary min-heap of the queued timer events, ordered by
+//                         TriggerTime and then by Sequence
+// mEfiTimerHeapCount    - Number of timer events in the heap
+// mEfiTimerHeapCapacity - Number of entries allocated for the heap
+// mEfiTimerEventCount   - Number of timer events in existence, each of which
+//                         has a heap entry reserved for it
+// mEfiTimerSequence     - Sequence number of the next timer to be queued
+//
+IEVENT           **mEfiTimerHeap = NULL;
+UINTN            mEfiTimerHeapCount = 0;
+UINTN            mEfiTimerHeapCapacity = 0;
+UINTN            mEfiTimerEventCount = 0;
+UINT64           mEfiTimerSequence = 0;
 EFI_LOCK         mEfiTimerLock = EFI_INITIALIZE_LOCK_VARIABLE (TPL_HIGH_LEVEL - 1);
 EFI_EVENT        mEfiCheckTimerEvent = NULL;
 
+//
+// mEfiTimerInsertCount  - Number of timers queued
+// mEfiTimerCompareCount - Number of trigger time compares done to keep the heap ordered
+// mEfiTimerHeapMaxCount - Largest number of timers queued at the same time
+//
+UINT64           mEfiTimerInsertCount = 0;
+UINT64           mEfiTimerCompareCount = 0;
+UINTN            mEfiTimerHeapMaxCount = 0;
+
 EFI_LOCK         mEfiSystemTimeLock = EFI_INITIALIZE_LOCK_VARIABLE (TPL_HIGH_LEVEL);
 UINT64           mEfiSystemTime = 0;
 
 //
 // Timer functions
 //
+/**
+  Reserves an entry in the timer heap for a new timer event, growing the
+  heap if needed.  Reserving the entry when the event is created means
+  that queueing the timer never has to allocate memory, which it could
+  not do at the TPL of mEfiTimerLock.
+
+  @retval EFI_SUCCESS            The entry was reserved
+  @retval EFI_OUT_OF_RESOURCES   The heap could not be grown
+
+**/
+EFI_STATUS
+CoreReserveTimerEvent (
+  VOID
+  )
+{
+  IEVENT          **NewHeap;
+  IEVENT          **OldHeap;
+  UINTN           Capacity;
+  UINTN           NewCapacity;
+
+  while (TRUE) {
+    CoreAcquireLock (&mEfiTimerLock);
+    if (mEfiTimerEventCount < mEfiTimerHeapCapacity) {
+      mEfiTimerEventCount++;
+      CoreReleaseLock (&mEfiTimerLock);
+      return EFI_SUCCESS;
+    }
+    Capacity = mEfiTimerHeapCapacity;
+    CoreReleaseLock (&mEfiTimerLock);
+
+    NewCapacity = MAX (Capacity * 2, TIMER_HEAP_INITIAL_SIZE);
+    NewHeap = AllocatePool (NewCapacity * sizeof (IEVENT *));
+    if (NewHeap == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+
+    //
+    // Another timer event may have grown the heap while it was unlocked
+    //
+    OldHeap = NewHeap;
+    CoreAcquireLock (&mEfiTimerLock);
+    if (mEfiTimerHeapCapacity == Capacity) {
+      CopyMem (NewHeap, mEfiTimerHeap, mEfiTimerHeapCount * sizeof (IEVENT *));
+      OldHeap               = mEfiTimerHeap;
+      mEfiTimerHeap         = NewHeap;
+      mEfiTimerHeapCapacity = NewCapacity;
+    }
+    CoreReleaseLock (&mEfiTimerLock);
+
+    if (OldHeap != NULL) {
+      CoreFreePool (OldHeap);
+    }
+  }
+}
+
+/**
+  Gives back the timer heap entry of a timer event that is being closed.
+  The timer must not be queued.
+
+**/
+VOID
+CoreReleaseTimerEvent (
+  VOID
+  )
+{
+  CoreAcquireLock (&mEfiTimerLock);
+  ASSERT (mEfiTimerEventCount > mEfiTimerHeapCount);
+  mEfiTimerEventCount--;
+  CoreReleaseLock (&mEfiTimerLock);
+}
+
+/**
+  Checks whether a timer event has to be signaled before another one.
+
+  @param  Event                  The timer event to check
+  @param  Event2                 The timer event to compare it with
+
+  @retval TRUE                   Event expires first, or at the same time
+                                 but was queued first
+  @retval FALSE                  Event2 has to be signaled first
+
+**/
+BOOLEAN
+CoreTimerExpiresBefore (
+  IN IEVENT   *Event,
+  IN IEVENT   *Event2
+  )
+{
+  mEfiTimerCompareCount++;
+  if (Event->Timer.TriggerTime != Event2->Timer.TriggerTime) {
+    return (BOOLEAN) (Event->Timer.TriggerTime < Event2->Timer.TriggerTime);
+  }
+  return (BOOLEAN) (Event->Timer.Sequence < Event2->Timer.Sequence);
+}
+
+/**
+  Stores a timer event at a position in the timer heap.
+
+  @param  Index                  Position in the heap
+  @param  Event                  The timer event
+
+**/
+VOID
+CoreSetTimerHeapEntry (
+  IN UINTN    Index,
+  IN IEVENT   *Event
+  )
+{
+  mEfiTimerHeap[Index]   = Event;
+  Event->Timer.HeapIndex = Index + 1;
+}
+
+/**
+  Restores the heap order around a timer event whose position or trigger
+  time has changed, by moving it up or down the timer heap.
+
+  @param  Event                  The timer event, already stored in the heap
+
+**/
+VOID
+CoreSiftEventTimer (
+  IN IEVENT   *Event
+  )
+{
+  UINTN           Index;
+  UINTN           Child;
+
+  Index = Event->Timer.HeapIndex - 1;
+
+  //
+  // Move the timer up while it expires before its parent
+  //
+  while (Index > 0 && CoreTimerExpiresBefore (Event, mEfiTimerHeap[(Index - 1) / 2])) {
+    CoreSetTimerHeapEntry (Index, mEfiTimerHeap[(Index - 1) / 2]);
+    Index = (Index - 1) / 2;
+  }
+
+  //
+  // Move the timer down while one of its children expires before it
+  //
+  while (TRUE) {
+    Child = Index * 2 + 1;
+    if (Child >= mEfiTimerHeapCount) {
+      break;
+    }
+    if (Child + 1 < mEfiTimerHeapCount &&
+        CoreTimerExpiresBefore (mEfiTimerHeap[Child + 1], mEfiTimerHeap[Child])) {
+      Child++;
+    }
+    if (!CoreTimerExpiresBefore (mEfiTimerHeap[Child], Event)) {
+      break;
+    }
+    CoreSetTimerHeapEntry (Index, mEfiTimerHeap[Child]);
+    Index = Child;
+  }
+
+  CoreSetTimerHeapEntry (Index, Event);
+}
+
 /**
   Inserts the timer event.
 
@@ -42,29 +223,74 @@ CoreInsertEventTimer (
   IN IEVENT   *Event
   )
 {
-  UINT64          TriggerTime;
-  LIST_ENTRY      *Link;
-  IEVENT          *Event2;
-
   ASSERT_LOCKED (&mEfiTimerLock);
+  ASSERT (Event->Timer.HeapIndex == 0);
+  ASSERT (mEfiTimerHeapCount < mEfiTimerHeapCapacity);
 
   //
-  // Get the timer's trigger time
+  // Timers with the same trigger time are signaled in the order they were queued
   //
-  TriggerTime = Event->Timer.TriggerTime;
+  Event->Timer.Sequence = mEfiTimerSequence++;
+
+  CoreSetTimerHeapEntry (mEfiTimerHeapCount, Event);
+  mEfiTimerHeapCount++;
+  CoreSiftEventTimer (Event);
+
+  mEfiTimerInsertCount++;
+  if (mEfiTimerHeapCount > mEfiTimerHeapMaxCount) {
+    mEfiTimerHeapMaxCount = mEfiTimerHeapCount;
+  }
+}
+
+/**
+  Removes the timer event from the timer heap.
+
+  @param  Event                  Points to the internal structure of a queued
+                                 timer event
+
+**/
+VOID
+CoreRemoveEventTimer (
+  IN IEVENT   *Event
+  )
+{
+  UINTN           Index;
+  IEVENT          *Last;
+
+  ASSERT_LOCKED (&mEfiTimerLock);
+  ASSERT (Event->Timer.HeapIndex != 0);
+
+  Index = Event->Timer.HeapIndex - 1;
+  Event->Timer.HeapIndex = 0;
 
   //
-  // Insert the timer into the timer database in assending sorted order
+  // Fill the hole with the last timer in the heap
   //
-  for (Link = mEfiTimerList.ForwardLink; Link != &mEfiTimerList; Link = Link->ForwardLink) {
-    Event2 = CR (Link, IEVENT, Timer.Link, EVENT_SIGNATURE);
-
-    if (Event2->Timer.TriggerTime > TriggerTime) {
-      break;
-    }
+  mEfiTimerHeapCount--;
+  if (Index != mEfiTimerHeapCount) {
+    Last = mEfiTimerHeap[mEfiTimerHeapCount];
+    CoreSetTimerHeapEntry (Index, Last);
+    CoreSiftEventTimer (Last);
   }
+}
 
-  InsertTailList (Link, &Event->Timer.Link);
+/**
+  Displays how many timers were queued and how many trigger time compares
+  it took to keep them in order.  Only used in Debug Builds.
+
+**/
+VOID
+CoreDisplayTimerStatistics (
+  VOID
+  )
+{
+  DEBUG ((
+    DEBUG_INFO,
+    "Timer heap: %ld timers queued, %ld compares, %d queued at most\n",
+    mEfiTimerInsertCount,
+    mEfiTimerCompareCount,
+    mEfiTimerHeapMaxCount
+    ));
 }
 
 /**
@@ -88,7 +314,7 @@ CoreCurrentSystemTime (
 }
 
 /**
-  Checks the sorted timer list against the current system time.
+  Checks the timer heap against the current system time.
   Signals any expired event timer.
 
   @param  CheckEvent             Not used
@@ -111,8 +337,8 @@ CoreCheckTimers (
   CoreAcquireLock (&mEfiTimerLock);
   SystemTime = CoreCurrentSystemTime ();
 
-  while (!IsListEmpty (&mEfiTimerList)) {
-    Event = CR (mEfiTimerList.ForwardLink, IEVENT, Timer.Link, EVENT_SIGNATURE);
+  while (mEfiTimerHeapCount != 0) {
+    Event = mEfiTimerHeap[0];
 
     //
     // If this timer is not expired, then we're done
@@ -125,8 +351,7 @@ CoreCheckTimers (
     // Remove this timer from the timer queue
     //
 
-    RemoveEntryList (&Event->Timer.Link);
-    Event->Timer.Link.ForwardLink = NULL;
+    CoreRemoveEventTimer (Event);
 
     //
     // Signal it
@@ -210,11 +435,11 @@ CoreTimerTick (
   mEfiSystemTime += Duration;
 
   //
-  // If the head of the list is expired, fire the timer event
+  // If the top of the heap is expired, fire the timer event
   // to process it
   //
-  if (!IsListEmpty (&mEfiTimerList)) {
-    Event = CR (mEfiTimerList.ForwardLink, IEVENT, Timer.Link, EVENT_SIGNATURE);
+  if (mEfiTimerHeapCount != 0) {
+    Event = mEfiTimerHeap[0];
 
     if (Event->Timer.TriggerTime <= mEfiSystemTime) {
       CoreSignalEvent (mEfiCheckTimerEvent);
@@ -270,9 +495,8 @@ CoreSetTimer (
   //
   // If the timer is queued to the timer database, remove it
   //
-  if (Event->Timer.Link.ForwardLink != NULL) {
-    RemoveEntryList (&Event->Timer.Link);
-    Event->Timer.Link.ForwardLink = NULL;
+  if (Event->Timer.HeapIndex != 0) {
+    CoreRemoveEventTimer (Event);
   }
 
   Event->Timer.TriggerTime = 0;
@@ -24,6 +24,14 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 VOID          *gEfiFwVolBlockNotifyReg;
 EFI_EVENT     gEfiFwVolBlockEvent;
 
+//
+// Statistics of the file name index and of the section offset cache
+//
+UINT64        mFvFileLookupCount = 0;
+UINT64        mFvFileCompareSavedCount = 0;
+UINT64        mFvSectionCacheHitCount = 0;
+UINT64        mFvSectionBytesSavedCount = 0;
+
 FV_DEVICE mFvDevice = {
   FV2_DEVICE_SIGNATURE,
   NULL,
@@ -48,7 +56,9 @@ FV_DEVICE mFvDevice = {
   0,
   0,
   FALSE,
-  FALSE
+  FALSE,
+  0,
+  { NULL }
 };
 
 
@@ -283,6 +293,10 @@ FreeFvDeviceResource (
       CoreFreePool (FfsFileEntry->FfsHeader);
     }
 
+    if (FfsFileEntry->SectionOffset != NULL) {
+      CoreFreePool (FfsFileEntry->SectionOffset);
+    }
+
     CoreFreePool (FfsFileEntry);
 
     FfsFileEntry = (FFS_FILE_LIST_ENTRY *) NextEntry;
@@ -341,6 +355,8 @@ FvCheck (
   BOOLEAN                               FileCached;
   UINTN                                 WholeFileSize;
   EFI_FFS_FILE_HEADER                   *CacheFfsHeader;
+  LIST_ENTRY                            *Link;
+  FFS_FILE_LIST_ENTRY                   **Bucket;
 
   FileCached = FALSE;
   CacheFfsHeader = NULL;
@@ -467,6 +483,8 @@ FvCheck (
   //
   Status = EFI_SUCCESS;
   InitializeListHead (&FvDevice->FfsFileListHeader);
+  FvDevice->FileCount = 0;
+  ZeroMem (FvDevice->FileHash, sizeof (FvDevice->FileHash));
 
   //
   // Build FFS list
@@ -578,6 +596,7 @@ FvCheck (
 
       FfsFileEntry->FfsHeader = CacheFfsHeader;
       FfsFileEntry->FileCached = FileCached;
+      FfsFileEntry->Index = FvDevice->FileCount++;
       FileCached = FALSE;
       InsertTailList (&FvDevice->FfsFileListHeader, &FfsFileEntry->Link);
     }
@@ -602,6 +621,25 @@ Done:
       FileCached = FALSE;
     }
     FreeFvDeviceResource (FvDevice);
+    return Status;
+  }
+
+  //
+  // Index the files by name for FvReadFile(). Pad files are skipped, as
+  // FvGetNextFile() never returns them. Walking the list backwards and
+  // inserting at the head keeps the files of a bucket in list order, so
+  // the first file of a given name is still the one found.
+  //
+  for (Link = FvDevice->FfsFileListHeader.BackLink;
+       Link != &FvDevice->FfsFileListHeader;
+       Link = Link->BackLink) {
+    FfsFileEntry = (FFS_FILE_LIST_ENTRY *) Link;
+    if (FfsFileEntry->FfsHeader->Type == EFI_FV_FILETYPE_FFS_PAD) {
+      continue;
+    }
+    Bucket = &FvDevice->FileHash[FV_FILE_HASH (&FfsFileEntry->FfsHeader->Name)];
+    FfsFileEntry->HashNext = *Bucket;
+    *Bucket = FfsFileEntry;
   }
 
   return Status;
@@ -609,6 +647,29 @@ Done:
 
 
 
+/**
+  Displays how many files were looked up by name, how many file name
+  compares the index saved, and how many bytes of section stream the section
+  offset cache did not have to walk.  Only used in Debug Builds.
+
+**/
+VOID
+CoreDisplayFwVolStatistics (
+  VOID
+  )
+{
+  DEBUG ((
+    DEBUG_INFO,
+    "FV: %ld file lookups, %ld compares saved, %ld section cache hits, %ld section bytes not walked\n",
+    mFvFileLookupCount,
+    mFvFileCompareSavedCount,
+    mFvSectionCacheHitCount,
+    mFvSectionBytesSavedCount
+    ));
+}
+
+
+
 /**
   This notification function is invoked when an instance of the
   EFI_FIRMWARE_VOLUME_BLOCK_PROTOCOL is produced.  It layers an instance of the
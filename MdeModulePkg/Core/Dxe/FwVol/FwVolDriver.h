@@ -19,15 +19,34 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 
 #define FV2_DEVICE_SIGNATURE SIGNATURE_32 ('_', 'F', 'V', '2')
 
+//
+// Number of buckets of the file name index of a FV. Must be a power of 2.
+//
+#define FV_FILE_HASH_SIZE    128
+
+#define FV_FILE_HASH(Guid)   ((Guid)->Data1 & (FV_FILE_HASH_SIZE - 1))
+
 //
 // Used to track all non-deleted files
 //
-typedef struct {
+typedef struct _FFS_FILE_LIST_ENTRY FFS_FILE_LIST_ENTRY;
+
+struct _FFS_FILE_LIST_ENTRY {
   LIST_ENTRY                      Link;
   EFI_FFS_FILE_HEADER             *FfsHeader;
   UINTN                           StreamHandle;
   BOOLEAN                         FileCached;
-} FFS_FILE_LIST_ENTRY;
+
+  UINTN                           Index;            // Position in FfsFileListHeader
+  FFS_FILE_LIST_ENTRY             *HashNext;        // Next file in the same FileHash bucket
+
+  //
+  // Offsets of the sections of the file, if none of them encapsulates others
+  //
+  BOOLEAN                         SectionsScanned;
+  UINTN                           SectionCount;
+  UINT32                          *SectionOffset;
+};
 
 typedef struct {
   UINTN                                   Signature;
@@ -47,10 +66,25 @@ typedef struct {
   UINT8                                   ErasePolarity;
   BOOLEAN                                 IsFfs3Fv;
   BOOLEAN                                 IsMemoryMapped;
+
+  //
+  // Index of the non-pad files by name. Files of the same name are chained in
+  // the order of FfsFileListHeader.
+  //
+  UINTN                                   FileCount;
+  FFS_FILE_LIST_ENTRY                     *FileHash[FV_FILE_HASH_SIZE];
 } FV_DEVICE;
 
 #define FV_DEVICE_FROM_THIS(a) CR(a, FV_DEVICE, Fv, FV2_DEVICE_SIGNATURE)
 
+//
+// Statistics of the file name index and of the section offset cache
+//
+extern UINT64  mFvFileLookupCount;
+extern UINT64  mFvFileCompareSavedCount;
+extern UINT64  mFvSectionCacheHitCount;
+extern UINT64  mFvSectionBytesSavedCount;
+
 /**
   Retrieves attributes, insures positive polarity of attribute bits, returns
   resulting attributes in output parameter.
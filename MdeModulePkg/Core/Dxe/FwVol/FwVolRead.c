@@ -273,9 +273,9 @@ FvReadFile (
 {
   EFI_STATUS                        Status;
   FV_DEVICE                         *FvDevice;
-  EFI_GUID                          SearchNameGuid;
-  EFI_FV_FILETYPE                   LocalFoundType;
-  EFI_FV_FILE_ATTRIBUTES            LocalAttributes;
+  EFI_FV_ATTRIBUTES                 FvAttributes;
+  FFS_FILE_LIST_ENTRY               *FfsFileEntry;
+  UINTN                             Compares;
   UINTN                             FileSize;
   UINT8                             *SrcPtr;
   EFI_FFS_FILE_HEADER               *FfsHeader;
@@ -288,31 +288,44 @@ FvReadFile (
 
   FvDevice = FV_DEVICE_FROM_THIS (This);
 
+  //
+  // Check if read operation is enabled
+  //
+  Status = FvGetVolumeAttributes (This, &FvAttributes);
+  if (EFI_ERROR (Status) || ((FvAttributes & EFI_FV2_READ_STATUS) == 0)) {
+    return EFI_NOT_FOUND;
+  }
 
   //
-  // Keep looking until we find the matching NameGuid.
+  // Look up the first file of that name in the index built by FvCheck().
   // The Key is really a FfsFileEntry
   //
-  FvDevice->LastKey = 0;
-  do {
-    LocalFoundType = 0;
-    Status = FvGetNextFile (
-              This,
-              &FvDevice->LastKey,
-              &LocalFoundType,
-              &SearchNameGuid,
-              &LocalAttributes,
-              &FileSize
-              );
-    if (EFI_ERROR (Status)) {
-      return EFI_NOT_FOUND;
+  mFvFileLookupCount++;
+  Compares = 0;
+  for (FfsFileEntry = FvDevice->FileHash[FV_FILE_HASH (NameGuid)];
+       FfsFileEntry != NULL;
+       FfsFileEntry = FfsFileEntry->HashNext) {
+    Compares++;
+    if (CompareGuid (&FfsFileEntry->FfsHeader->Name, NameGuid)) {
+      break;
     }
-  } while (!CompareGuid (&SearchNameGuid, NameGuid));
+  }
+  if (FfsFileEntry == NULL) {
+    mFvFileCompareSavedCount += FvDevice->FileCount - Compares;
+    return EFI_NOT_FOUND;
+  }
+  mFvFileCompareSavedCount += FfsFileEntry->Index + 1 - Compares;
+  FvDevice->LastKey = FfsFileEntry;
 
   //
   // Get a pointer to the header
   //
   FfsHeader = FvDevice->LastKey->FfsHeader;
+  if (IS_FFS_FILE2 (FfsHeader)) {
+    FileSize = FFS_FILE2_SIZE (FfsHeader) - sizeof (EFI_FFS_FILE_HEADER2);
+  } else {
+    FileSize = FFS_FILE_SIZE (FfsHeader) - sizeof (EFI_FFS_FILE_HEADER);
+  }
   if (FvDevice->IsMemoryMapped) {
     //
     // Memory mapped FV has not been cached, so here is to cache by file.
@@ -393,6 +406,175 @@ FvReadFile (
 
 
 
+/**
+  Record where the sections of a file are, so that FvReadFileSection() does
+  not have to walk its section stream again.  Nothing is recorded if a
+  section encapsulates others, as the instance numbers of a section type then
+  depend on the encapsulated streams too, or if a section is not readable
+  from this FV.
+
+  @param  FvDevice              The FV the file is in.
+  @param  FfsEntry              The file.
+  @param  FileBuffer            The section stream of the file.
+  @param  FileSize              The size of the section stream.
+
+**/
+VOID
+FvCacheSectionOffsets (
+  IN     FV_DEVICE                *FvDevice,
+  IN OUT FFS_FILE_LIST_ENTRY      *FfsEntry,
+  IN     UINT8                    *FileBuffer,
+  IN     UINTN                    FileSize
+  )
+{
+  EFI_COMMON_SECTION_HEADER       *Section;
+  UINT32                          *SectionOffset;
+  UINTN                           Count;
+  UINTN                           Offset;
+  UINTN                           SectionSize;
+
+  FfsEntry->SectionsScanned = TRUE;
+
+  //
+  // Count the sections, stepping through the stream as FindChildNode() does
+  //
+  Count = 0;
+  for (Offset = 0; Offset + sizeof (EFI_COMMON_SECTION_HEADER) <= FileSize; Offset = ALIGN_VALUE (Offset + SectionSize, 4)) {
+    Section = (EFI_COMMON_SECTION_HEADER *) (FileBuffer + Offset);
+    if (IS_SECTION2 (Section)) {
+      if (!FvDevice->IsFfs3Fv || (Offset + sizeof (EFI_COMMON_SECTION_HEADER2) > FileSize)) {
+        return;
+      }
+      SectionSize = SECTION2_SIZE (Section);
+    } else {
+      SectionSize = SECTION_SIZE (Section);
+    }
+    if ((SectionSize < sizeof (EFI_COMMON_SECTION_HEADER)) || (SectionSize > FileSize - Offset) ||
+        (Section->Type == EFI_SECTION_COMPRESSION) || (Section->Type == EFI_SECTION_GUID_DEFINED)) {
+      return;
+    }
+    Count++;
+  }
+  if (Count == 0 || Offset < FileSize) {
+    return;
+  }
+
+  SectionOffset = AllocatePool (Count * sizeof (UINT32));
+  if (SectionOffset == NULL) {
+    return;
+  }
+
+  Count = 0;
+  for (Offset = 0; Offset + sizeof (EFI_COMMON_SECTION_HEADER) <= FileSize; Offset = ALIGN_VALUE (Offset + SectionSize, 4)) {
+    Section = (EFI_COMMON_SECTION_HEADER *) (FileBuffer + Offset);
+    SectionSize = IS_SECTION2 (Section) ? SECTION2_SIZE (Section) : SECTION_SIZE (Section);
+    SectionOffset[Count++] = (UINT32) Offset;
+  }
+
+  FfsEntry->SectionOffset = SectionOffset;
+  FfsEntry->SectionCount  = Count;
+}
+
+
+
+/**
+  Copy a section of a file from the offsets recorded by
+  FvCacheSectionOffsets(), the same way GetSection() would have.
+
+  @param  FfsEntry              The file.
+  @param  FileBuffer            The section stream of the file.
+  @param  SectionType           Indicates the section type to return.
+  @param  SectionInstance       Indicates which instance of sections with a
+                                type of SectionType to return.
+  @param  Buffer                Buffer is a pointer to pointer to a buffer in
+                                which the section contents are returned.
+  @param  BufferSize            BufferSize is a pointer to caller allocated
+                                UINTN.
+  @param  AuthenticationStatus  The authentication status of the section.
+
+  @retval EFI_SUCCESS                Successfully read the file section into
+                                     buffer.
+  @retval EFI_WARN_BUFFER_TOO_SMALL  Buffer too small.
+  @retval EFI_NOT_FOUND              Section not found.
+  @retval EFI_OUT_OF_RESOURCES       Not enough buffer to be allocated.
+
+**/
+EFI_STATUS
+FvReadCachedSection (
+  IN     FFS_FILE_LIST_ENTRY      *FfsEntry,
+  IN     UINT8                    *FileBuffer,
+  IN     EFI_SECTION_TYPE         SectionType,
+  IN     UINTN                    SectionInstance,
+  IN OUT VOID                     **Buffer,
+  IN OUT UINTN                    *BufferSize,
+  OUT    UINT32                   *AuthenticationStatus
+  )
+{
+  EFI_STATUS                      Status;
+  EFI_COMMON_SECTION_HEADER       *Section;
+  UINTN                           Index;
+  UINTN                           CopySize;
+  UINTN                           SectionSize;
+  UINT8                           *CopyBuffer;
+
+  Section = NULL;
+  for (Index = 0; Index < FfsEntry->SectionCount; Index++) {
+    Section = (EFI_COMMON_SECTION_HEADER *) (FileBuffer + FfsEntry->SectionOffset[Index]);
+    if (Section->Type == SectionType) {
+      if (SectionInstance == 0) {
+        break;
+      }
+      SectionInstance--;
+    }
+  }
+  if (Index == FfsEntry->SectionCount) {
+    return EFI_NOT_FOUND;
+  }
+
+  mFvSectionCacheHitCount++;
+  mFvSectionBytesSavedCount += FfsEntry->SectionOffset[Index];
+
+  if (IS_SECTION2 (Section)) {
+    CopySize = SECTION2_SIZE (Section) - sizeof (EFI_COMMON_SECTION_HEADER2);
+    CopyBuffer = (UINT8 *) Section + sizeof (EFI_COMMON_SECTION_HEADER2);
+  } else {
+    CopySize = SECTION_SIZE (Section) - sizeof (EFI_COMMON_SECTION_HEADER);
+    CopyBuffer = (UINT8 *) Section + sizeof (EFI_COMMON_SECTION_HEADER);
+  }
+
+  Status = EFI_SUCCESS;
+  SectionSize = CopySize;
+  if (*Buffer != NULL) {
+    //
+    // Caller allocated buffer.  Fill to size and return required size...
+    //
+    if (*BufferSize < CopySize) {
+      Status = EFI_WARN_BUFFER_TOO_SMALL;
+      CopySize = *BufferSize;
+    }
+  } else {
+    //
+    // Callee allocated buffer.  Allocate buffer and return size.
+    //
+    *Buffer = AllocatePool (CopySize);
+    if (*Buffer == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+  }
+  CopyMem (*Buffer, CopyBuffer, CopySize);
+  *BufferSize = SectionSize;
+
+  //
+  // Sections that are not encapsulated have the authentication status of
+  // the section stream, which is 0 for a stream opened by OpenSectionStream()
+  //
+  *AuthenticationStatus = 0;
+
+  return Status;
+}
+
+
+
 /**
   Locates a section in a given FFS File and
   copies it to the supplied buffer (not including section header).
@@ -495,18 +677,38 @@ FvReadFileSection (
   }
 
   //
-  // If SectionType == 0 We need the whole section stream
+  // If none of the sections of the file encapsulates others, read the section
+  // straight from the file using the offsets cached for it
   //
-  Status = GetSection (
-             FfsEntry->StreamHandle,
-             (SectionType == 0) ? NULL : &SectionType,
-             NULL,
-             (SectionType == 0) ? 0 : SectionInstance,
-             Buffer,
-             BufferSize,
-             AuthenticationStatus,
-             FvDevice->IsFfs3Fv
-             );
+  if (SectionType != 0 && !FfsEntry->SectionsScanned) {
+    FvCacheSectionOffsets (FvDevice, FfsEntry, FileBuffer, FileSize);
+  }
+
+  if (SectionType != 0 && FfsEntry->SectionOffset != NULL) {
+    Status = FvReadCachedSection (
+               FfsEntry,
+               FileBuffer,
+               SectionType,
+               SectionInstance,
+               Buffer,
+               BufferSize,
+               AuthenticationStatus
+               );
+  } else {
+    //
+    // If SectionType == 0 We need the whole section stream
+    //
+    Status = GetSection (
+               FfsEntry->StreamHandle,
+               (SectionType == 0) ? NULL : &SectionType,
+               NULL,
+               (SectionType == 0) ? 0 : SectionInstance,
+               Buffer,
+               BufferSize,
+               AuthenticationStatus,
+               FvDevice->IsFfs3Fv
+               );
+  }
 
   if (!EFI_ERROR (Status)) {
     //
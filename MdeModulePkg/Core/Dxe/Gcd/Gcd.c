@@ -49,6 +49,10 @@ EFI_LOCK           mGcdMemorySpaceLock = EFI_INITIALIZE_LOCK_VARIABLE (TPL_NOTIF
 EFI_LOCK           mGcdIoSpaceLock     = EFI_INITIALIZE_LOCK_VARIABLE (TPL_NOTIFY);
 LIST_ENTRY         mGcdMemorySpaceMap  = INITIALIZE_LIST_HEAD_VARIABLE (mGcdMemorySpaceMap);
 LIST_ENTRY         mGcdIoSpaceMap      = INITIALIZE_LIST_HEAD_VARIABLE (mGcdIoSpaceMap);
+//
+// Bumped every time the types, capabilities or attributes in mGcdMemorySpaceMap change
+//
+UINTN              mGcdMemorySpaceMapKey = 0;
 
 EFI_GCD_MAP_ENTRY mGcdMemorySpaceMapEntryTemplate = {
   EFI_GCD_MAP_SIGNATURE,
@@ -938,6 +942,9 @@ CoreConvertSpace (
   // Cleanup
   //
   Status = CoreCleanupGcdMapEntry (TopEntry, BottomEntry, StartLink, EndLink, Map);
+  if ((Operation & GCD_MEMORY_SPACE_OPERATION) != 0) {
+    mGcdMemorySpaceMapKey++;
+  }
 
 Done:
   DEBUG ((DEBUG_GCD, "  Status = %r\n", Status));
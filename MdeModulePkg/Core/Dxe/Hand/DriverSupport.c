@@ -15,6 +15,12 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include "DxeMain.h"
 #include "Handle.h"
 
+//
+// Driver Binding Supported() calls made, and calls skipped because the driver
+// binding was known not to support the controller
+//
+UINT64  mDriverBindingSupportedCount = 0;
+UINT64  mDriverBindingSupportedSkipCount = 0;
 
 //
 // Driver Support Functions
@@ -361,6 +367,25 @@ AddSortedDriverBindingProtocol (
 }
 
 
+/**
+  Displays how many driver binding Supported() calls ConnectController() made
+  and how many it skipped.  Only used in Debug Builds.
+
+**/
+VOID
+CoreDisplayDriverBindingStatistics (
+  VOID
+  )
+{
+  DEBUG ((
+    DEBUG_INFO,
+    "ConnectController: %ld Supported() calls, %ld skipped\n",
+    mDriverBindingSupportedCount,
+    mDriverBindingSupportedSkipCount
+    ));
+}
+
+
 /**
   Connects a controller to a driver.
 
@@ -408,6 +433,8 @@ CoreConnectSingleController (
   UINTN                                      SortIndex;
   BOOLEAN                                    OneStarted;
   BOOLEAN                                    DriverFound;
+  BOOLEAN                                    *Unsupported;
+  UINT64                                     UnsupportedKey;
 
   //
   // Initialize local variables
@@ -611,12 +638,32 @@ CoreConnectSingleController (
     }
   }
 
+  //
+  // Remember the drivers whose Supported() returned EFI_UNSUPPORTED, so that
+  // they are not asked again each time another driver has been started.  As
+  // Supported() may depend on any state, this only lasts for this call, and is
+  // forgotten when a protocol interface on ControllerHandle changes.  Nothing
+  // is remembered if memory is short.
+  //
+  Unsupported    = AllocateZeroPool (NumberOfSortedDriverBindingProtocols * sizeof (BOOLEAN));
+  UnsupportedKey = ((IHANDLE *) ControllerHandle)->ProtocolKey;
+
   //
   // Loop until no more drivers can be started on ControllerHandle
   //
   OneStarted = FALSE;
   do {
 
+    if (Unsupported != NULL) {
+      if (EFI_ERROR (CoreValidateHandle (ControllerHandle))) {
+        CoreFreePool (Unsupported);
+        Unsupported = NULL;
+      } else if (((IHANDLE *) ControllerHandle)->ProtocolKey != UnsupportedKey) {
+        ZeroMem (Unsupported, NumberOfSortedDriverBindingProtocols * sizeof (BOOLEAN));
+        UnsupportedKey = ((IHANDLE *) ControllerHandle)->ProtocolKey;
+      }
+    }
+
     //
     // Loop through the sorted Driver Binding Protocol Instances in order, and see if
     // any of the Driver Binding Protocols support the controller specified by
@@ -627,6 +674,17 @@ CoreConnectSingleController (
     for (Index = 0; (Index < NumberOfSortedDriverBindingProtocols) && !DriverFound; Index++) {
       if (SortedDriverBindingProtocols[Index] != NULL) {
         DriverBinding = SortedDriverBindingProtocols[Index];
+
+        //
+        // Skip the drivers that have already reported they do not support the
+        // controller.
+        //
+        if ((Unsupported != NULL) && Unsupported[Index]) {
+          mDriverBindingSupportedSkipCount++;
+          continue;
+        }
+
+        mDriverBindingSupportedCount++;
         PERF_START (DriverBinding->DriverBindingHandle, "DB:Support:", NULL, 0);
         Status = DriverBinding->Supported(
                                   DriverBinding,
@@ -634,6 +692,9 @@ CoreConnectSingleController (
                                   RemainingDevicePath
                                   );
         PERF_END (DriverBinding->DriverBindingHandle, "DB:Support:", NULL, 0);
+        if ((Status == EFI_UNSUPPORTED) && (Unsupported != NULL)) {
+          Unsupported[Index] = TRUE;
+        }
         if (!EFI_ERROR (Status)) {
           SortedDriverBindingProtocols[Index] = NULL;
           DriverFound = TRUE;
@@ -665,6 +726,9 @@ CoreConnectSingleController (
   // Free any buffers that were allocated with AllocatePool()
   //
   CoreFreePool (SortedDriverBindingProtocols);
+  if (Unsupported != NULL) {
+    CoreFreePool (Unsupported);
+  }
 
   //
   // If at least one driver was started on ControllerHandle, then return EFI_SUCCESS.
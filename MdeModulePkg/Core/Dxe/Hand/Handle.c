@@ -17,16 +17,36 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 
 
 //
-// mProtocolDatabase     - A list of all protocols in the system.  (simple list for now)
+// mProtocolDatabase     - A list of all protocols in the system.
+// mProtocolHashTable    - The same protocols hashed by GUID, for CoreFindProtocolEntry()
 // gHandleList           - A list of all the handles in the system
+// mHandleHashTable      - The same handles hashed by address, for CoreValidateHandle()
 // gProtocolDatabaseLock - Lock to protect the mProtocolDatabase
 // gHandleDatabaseKey    -  The Key to show that the handle has been created/modified
 //
 LIST_ENTRY      mProtocolDatabase     = INITIALIZE_LIST_HEAD_VARIABLE (mProtocolDatabase);
+LIST_ENTRY      mProtocolHashTable[PROTOCOL_HASH_TABLE_SIZE];
 LIST_ENTRY      gHandleList           = INITIALIZE_LIST_HEAD_VARIABLE (gHandleList);
+LIST_ENTRY      mHandleHashTableInitial[HANDLE_HASH_TABLE_INITIAL_SIZE];
+LIST_ENTRY      *mHandleHashTable     = mHandleHashTableInitial;
+UINTN           mHandleHashTableSize  = HANDLE_HASH_TABLE_INITIAL_SIZE;
+UINTN           mHandleCount          = 0;
 EFI_LOCK        gProtocolDatabaseLock = EFI_INITIALIZE_LOCK_VARIABLE (TPL_NOTIFY);
 UINT64          gHandleDatabaseKey    = 0;
 
+//
+// mProtocolEntryCount   - Number of protocol entries created so far
+// mProtocolLookupCount  - Number of protocol entry lookups by GUID
+// mProtocolProbeCount   - Number of GUID compares done by those lookups
+// mHandleIndexHitCount  - Number of protocol interfaces found in IHANDLE.ProtocolIndex
+// mHandleIndexMissCount - Number of protocol interface lookups that had to walk the handle
+//
+UINTN           mProtocolEntryCount   = 0;
+UINT64          mProtocolLookupCount  = 0;
+UINT64          mProtocolProbeCount   = 0;
+UINT64          mHandleIndexHitCount  = 0;
+UINT64          mHandleIndexMissCount = 0;
+
 
 
 /**
@@ -58,7 +78,136 @@ CoreReleaseProtocolLock (
 
 
 /**
-  Check whether a handle is a valid EFI_HANDLE
+  Computes the handle registry bucket of a handle from its address.
+
+  @param  Handle                 The handle
+  @param  TableSize              Number of buckets, a power of 2
+
+  @return Index of the bucket
+
+**/
+UINTN
+CoreHandleHash (
+  IN CONST VOID   *Handle,
+  IN UINTN        TableSize
+  )
+{
+  UINTN               Hash;
+
+  //
+  // Handles are pool allocations, so the lowest bits carry no information
+  //
+  Hash = (UINTN) Handle >> 3;
+  Hash ^= Hash >> 9;
+  return Hash & (TableSize - 1);
+}
+
+
+
+/**
+  Doubles the number of buckets in the handle registry and rehashes
+  all registered handles.  If memory runs out the registry keeps its
+  current size, which only makes the lookups slower.
+  The gProtocolDatabaseLock must be owned
+
+**/
+VOID
+CoreGrowHandleRegistry (
+  VOID
+  )
+{
+  LIST_ENTRY          *NewTable;
+  UINTN               NewSize;
+  LIST_ENTRY          *Link;
+  IHANDLE             *Handle;
+  UINTN               Index;
+
+  ASSERT_LOCKED(&gProtocolDatabaseLock);
+
+  NewSize  = mHandleHashTableSize * 2;
+  NewTable = AllocatePool (NewSize * sizeof (LIST_ENTRY));
+  if (NewTable == NULL) {
+    return;
+  }
+
+  for (Index = 0; Index < NewSize; Index++) {
+    InitializeListHead (&NewTable[Index]);
+  }
+  for (Link = gHandleList.ForwardLink; Link != &gHandleList; Link = Link->ForwardLink) {
+    Handle = CR (Link, IHANDLE, AllHandles, EFI_HANDLE_SIGNATURE);
+    InsertTailList (&NewTable[CoreHandleHash (Handle, NewSize)], &Handle->HashLink);
+  }
+
+  if (mHandleHashTable != mHandleHashTableInitial) {
+    CoreFreePool (mHandleHashTable);
+  }
+  mHandleHashTable     = NewTable;
+  mHandleHashTableSize = NewSize;
+}
+
+
+
+/**
+  Adds a new handle to gHandleList and to the handle registry.
+  The gProtocolDatabaseLock must be owned
+
+  @param  Handle                 The new handle
+
+**/
+VOID
+CoreRegisterHandle (
+  IN IHANDLE    *Handle
+  )
+{
+  UINTN               Index;
+
+  ASSERT_LOCKED(&gProtocolDatabaseLock);
+
+  //
+  // The hash table cannot be initialized statically
+  //
+  if (mHandleHashTableInitial[0].ForwardLink == NULL) {
+    for (Index = 0; Index < HANDLE_HASH_TABLE_INITIAL_SIZE; Index++) {
+      InitializeListHead (&mHandleHashTableInitial[Index]);
+    }
+  }
+
+  InsertTailList (&gHandleList, &Handle->AllHandles);
+  InsertTailList (&mHandleHashTable[CoreHandleHash (Handle, mHandleHashTableSize)], &Handle->HashLink);
+  mHandleCount++;
+
+  if (mHandleCount > mHandleHashTableSize * 2) {
+    CoreGrowHandleRegistry ();
+  }
+}
+
+
+
+/**
+  Removes a handle from gHandleList and from the handle registry.
+  The gProtocolDatabaseLock must be owned
+
+  @param  Handle                 The handle to remove
+
+**/
+VOID
+CoreUnregisterHandle (
+  IN IHANDLE    *Handle
+  )
+{
+  ASSERT_LOCKED(&gProtocolDatabaseLock);
+
+  RemoveEntryList (&Handle->AllHandles);
+  RemoveEntryList (&Handle->HashLink);
+  mHandleCount--;
+}
+
+
+
+/**
+  Check whether a handle is a valid EFI_HANDLE.  The handle is looked
+  up by its address in the handle registry before anything is read
+  through it, so bogus pointers are rejected without being dereferenced.
 
   @param  UserHandle             The handle to check
 
@@ -72,15 +221,65 @@ CoreValidateHandle (
   )
 {
   IHANDLE             *Handle;
+  LIST_ENTRY          *Bucket;
+  LIST_ENTRY          *Link;
+  BOOLEAN             LockHeld;
+  EFI_STATUS          Status;
 
-  Handle = (IHANDLE *)UserHandle;
-  if (Handle == NULL) {
+  if (UserHandle == NULL) {
     return EFI_INVALID_PARAMETER;
   }
-  if (Handle->Signature != EFI_HANDLE_SIGNATURE) {
-    return EFI_INVALID_PARAMETER;
+
+  //
+  // Some boot services validate their handles before they take the lock
+  //
+  LockHeld = (BOOLEAN) (gProtocolDatabaseLock.Lock == EfiLockAcquired);
+  if (!LockHeld) {
+    CoreAcquireProtocolLock ();
   }
-  return EFI_SUCCESS;
+
+  Status = EFI_INVALID_PARAMETER;
+  if (mHandleHashTable[0].ForwardLink != NULL) {
+    Bucket = &mHandleHashTable[CoreHandleHash (UserHandle, mHandleHashTableSize)];
+    for (Link = Bucket->ForwardLink; Link != Bucket; Link = Link->ForwardLink) {
+      Handle = CR (Link, IHANDLE, HashLink, EFI_HANDLE_SIGNATURE);
+      if (Handle == (IHANDLE *) UserHandle) {
+        Status = EFI_SUCCESS;
+        break;
+      }
+    }
+  }
+
+  if (!LockHeld) {
+    CoreReleaseProtocolLock ();
+  }
+  return Status;
+}
+
+
+
+/**
+  Computes the mProtocolHashTable bucket of a protocol GUID.
+
+  @param  Protocol               The ID of the protocol
+
+  @return Index of the bucket
+
+**/
+UINTN
+CoreProtocolHash (
+  IN EFI_GUID   *Protocol
+  )
+{
+  UINT32              Hash;
+
+  Hash = ReadUnaligned32 ((UINT32 *) Protocol) ^
+         ReadUnaligned32 ((UINT32 *) Protocol + 1) ^
+         ReadUnaligned32 ((UINT32 *) Protocol + 2) ^
+         ReadUnaligned32 ((UINT32 *) Protocol + 3);
+  Hash ^= Hash >> 16;
+  Hash ^= Hash >> 8;
+  return Hash & (PROTOCOL_HASH_TABLE_SIZE - 1);
 }
 
 
@@ -101,22 +300,36 @@ CoreFindProtocolEntry (
   IN BOOLEAN    Create
   )
 {
+  LIST_ENTRY          *Bucket;
   LIST_ENTRY          *Link;
   PROTOCOL_ENTRY      *Item;
   PROTOCOL_ENTRY      *ProtEntry;
+  UINTN               Index;
 
   ASSERT_LOCKED(&gProtocolDatabaseLock);
 
   //
-  // Search the database for the matching GUID
+  // The hash table cannot be initialized statically
   //
+  if (mProtocolHashTable[0].ForwardLink == NULL) {
+    for (Index = 0; Index < PROTOCOL_HASH_TABLE_SIZE; Index++) {
+      InitializeListHead (&mProtocolHashTable[Index]);
+    }
+  }
 
+  //
+  // Search the bucket of the GUID for a matching entry
+  //
+
+  mProtocolLookupCount++;
+  Bucket = &mProtocolHashTable[CoreProtocolHash (Protocol)];
   ProtEntry = NULL;
-  for (Link = mProtocolDatabase.ForwardLink;
-       Link != &mProtocolDatabase;
+  for (Link = Bucket->ForwardLink;
+       Link != Bucket;
        Link = Link->ForwardLink) {
 
-    Item = CR(Link, PROTOCOL_ENTRY, AllEntries, PROTOCOL_ENTRY_SIGNATURE);
+    Item = CR(Link, PROTOCOL_ENTRY, HashLink, PROTOCOL_ENTRY_SIGNATURE);
+    mProtocolProbeCount++;
     if (CompareGuid (&Item->ProtocolID, Protocol)) {
 
       //
@@ -140,6 +353,7 @@ CoreFindProtocolEntry (
       // Initialize new protocol entry structure
       //
       ProtEntry->Signature = PROTOCOL_ENTRY_SIGNATURE;
+      ProtEntry->Index = mProtocolEntryCount++;
       CopyGuid ((VOID *)&ProtEntry->ProtocolID, Protocol);
       InitializeListHead (&ProtEntry->Protocols);
       InitializeListHead (&ProtEntry->Notify);
@@ -148,6 +362,7 @@ CoreFindProtocolEntry (
       // Add it to protocol database
       //
       InsertTailList (&mProtocolDatabase, &ProtEntry->AllEntries);
+      InsertTailList (Bucket, &ProtEntry->HashLink);
     }
   }
 
@@ -156,6 +371,40 @@ CoreFindProtocolEntry (
 
 
 
+/**
+  Displays how many protocol entry lookups were done and how many GUID
+  compares they took, how often protocol interfaces were found in
+  the per-handle index, and how large the handle registry has grown.
+  Only used in Debug Builds.
+
+**/
+VOID
+CoreDisplayProtocolDatabaseStatistics (
+  VOID
+  )
+{
+  DEBUG ((
+    DEBUG_INFO,
+    "Protocol database: %ld lookups, %ld GUID compares\n",
+    mProtocolLookupCount,
+    mProtocolProbeCount
+    ));
+  DEBUG ((
+    DEBUG_INFO,
+    "Handle protocol index: %ld hits, %ld misses\n",
+    mHandleIndexHitCount,
+    mHandleIndexMissCount
+    ));
+  DEBUG ((
+    DEBUG_INFO,
+    "Handle registry: %d handles in %d buckets\n",
+    mHandleCount,
+    mHandleHashTableSize
+    ));
+}
+
+
+
 /**
   Finds the protocol instance for the requested handle and protocol.
   Note: This function doesn't do parameters checking, it's caller's responsibility
@@ -427,7 +676,7 @@ CoreInstallProtocolInterfaceNotify (
     // Add this handle to the list global list of all handles
     // in the system
     //
-    InsertTailList (&gHandleList, &Handle->AllHandles);
+    CoreRegisterHandle (Handle);
   }
 
   Status = CoreValidateHandle (Handle);
@@ -466,6 +715,12 @@ CoreInstallProtocolInterfaceNotify (
   //
   InsertTailList (&ProtEntry->Protocols, &Prot->ByProtocol);
 
+  //
+  // Update the ProtocolKey to show that the protocols on the handle have changed
+  //
+  gHandleDatabaseKey++;
+  Handle->ProtocolKey = gHandleDatabaseKey;
+
   //
   // Notify the notification list for this protocol
   //
@@ -718,6 +973,7 @@ CoreUninstallProtocolInterface (
   EFI_STATUS            Status;
   IHANDLE               *Handle;
   PROTOCOL_INTERFACE    *Prot;
+  UINTN                 Slot;
 
   //
   // Check that Protocol is valid
@@ -775,10 +1031,15 @@ CoreUninstallProtocolInterface (
     //
     gHandleDatabaseKey++;
     Handle->Key = gHandleDatabaseKey;
+    Handle->ProtocolKey = gHandleDatabaseKey;
 
     //
-    // Remove the protocol interface from the handle
+    // Remove the protocol interface from the handle and its index
     //
+    Slot = Prot->Protocol->Index & (HANDLE_PROTOCOL_INDEX_SIZE - 1);
+    if (Handle->ProtocolIndex[Slot] == &Prot->Link) {
+      Handle->ProtocolIndex[Slot] = NULL;
+    }
     RemoveEntryList (&Prot->Link);
 
     //
@@ -793,8 +1054,8 @@ CoreUninstallProtocolInterface (
   // If there are no more handlers for the handle, free the handle
   //
   if (IsListEmpty (&Handle->Protocols)) {
+    CoreUnregisterHandle (Handle);
     Handle->Signature = 0;
-    RemoveEntryList (&Handle->AllHandles);
     CoreFreePool (Handle);
   }
 
@@ -878,6 +1139,7 @@ CoreUninstallMultipleProtocolInterfaces (
 
 /**
   Locate a certain GUID protocol interface in a Handle's protocols.
+  The gProtocolDatabaseLock must be owned.
 
   @param  UserHandle             The handle to obtain the protocol interface on
   @param  Protocol               The GUID of the protocol
@@ -896,6 +1158,7 @@ CoreGetProtocolInterface (
   PROTOCOL_INTERFACE  *Prot;
   IHANDLE             *Handle;
   LIST_ENTRY          *Link;
+  UINTN               Slot;
 
   Status = CoreValidateHandle (UserHandle);
   if (EFI_ERROR (Status)) {
@@ -905,12 +1168,34 @@ CoreGetProtocolInterface (
   Handle = (IHANDLE *)UserHandle;
 
   //
-  // Look at each protocol interface for a match
+  // No handle can have a protocol that was never installed
+  //
+  ProtEntry = CoreFindProtocolEntry (Protocol, FALSE);
+  if (ProtEntry == NULL) {
+    return NULL;
+  }
+
+  //
+  // Check the index of the handle first
+  //
+  Slot = ProtEntry->Index & (HANDLE_PROTOCOL_INDEX_SIZE - 1);
+  Link = Handle->ProtocolIndex[Slot];
+  if (Link != NULL) {
+    Prot = CR(Link, PROTOCOL_INTERFACE, Link, PROTOCOL_INTERFACE_SIGNATURE);
+    if (Prot->Protocol == ProtEntry) {
+      mHandleIndexHitCount++;
+      return Prot;
+    }
+  }
+
+  //
+  // Look at each protocol interface for a match and remember it
   //
+  mHandleIndexMissCount++;
   for (Link = Handle->Protocols.ForwardLink; Link != &Handle->Protocols; Link = Link->ForwardLink) {
     Prot = CR(Link, PROTOCOL_INTERFACE, Link, PROTOCOL_INTERFACE_SIGNATURE);
-    ProtEntry = Prot->Protocol;
-    if (CompareGuid (&ProtEntry->ProtocolID, Protocol)) {
+    if (Prot->Protocol == ProtEntry) {
+      Handle->ProtocolIndex[Slot] = Link;
       return Prot;
     }
   }
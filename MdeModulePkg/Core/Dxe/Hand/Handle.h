@@ -18,6 +18,11 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 
 #define EFI_HANDLE_SIGNATURE            SIGNATURE_32('h','n','d','l')
 
+///
+/// Number of protocol interfaces each handle remembers for fast lookup; a power of 2
+///
+#define HANDLE_PROTOCOL_INDEX_SIZE      8
+
 ///
 /// IHANDLE - contains a list of protocol handles
 ///
@@ -25,17 +30,35 @@ typedef struct {
   UINTN               Signature;
   /// All handles list of IHANDLE
   LIST_ENTRY          AllHandles;
+  /// Link Entry inserted to the handle registry bucket of this handle
+  LIST_ENTRY          HashLink;
   /// List of PROTOCOL_INTERFACE's for this handle
   LIST_ENTRY          Protocols;      
   UINTN               LocateRequest;
   /// The Handle Database Key value when this handle was last created or modified
   UINT64              Key;
+  /// The Handle Database Key value when a protocol interface was last installed,
+  /// uninstalled or reinstalled on this handle
+  UINT64              ProtocolKey;
+  /// PROTOCOL_INTERFACE.Link of recently looked up protocols, slot selected by PROTOCOL_ENTRY.Index
+  LIST_ENTRY          *ProtocolIndex[HANDLE_PROTOCOL_INDEX_SIZE];
 } IHANDLE;
 
 #define ASSERT_IS_HANDLE(a)  ASSERT((a)->Signature == EFI_HANDLE_SIGNATURE)
 
 #define PROTOCOL_ENTRY_SIGNATURE        SIGNATURE_32('p','r','t','e')
 
+///
+/// Number of buckets protocol entries are hashed into by GUID; a power of 2
+///
+#define PROTOCOL_HASH_TABLE_SIZE        128
+
+///
+/// Number of buckets the handle registry starts with; a power of 2,
+/// doubled whenever there are more than two handles per bucket
+///
+#define HANDLE_HASH_TABLE_INITIAL_SIZE  64
+
 ///
 /// PROTOCOL_ENTRY - each different protocol has 1 entry in the protocol
 /// database.  Each handler that supports this protocol is listed, along
@@ -45,6 +68,10 @@ typedef struct {
   UINTN               Signature;
   /// Link Entry inserted to mProtocolDatabase
   LIST_ENTRY          AllEntries;  
+  /// Link Entry inserted to the mProtocolHashTable bucket of ProtocolID
+  LIST_ENTRY          HashLink;
+  /// Sequence number of this entry, selects its slot in IHANDLE.ProtocolIndex
+  UINTN               Index;
   /// ID of the protocol
   EFI_GUID            ProtocolID;  
   /// All protocol interfaces
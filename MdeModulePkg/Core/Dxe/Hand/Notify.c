@@ -261,6 +261,7 @@ CoreReinstallProtocolInterface (
   //
   gHandleDatabaseKey++;
   Handle->Key = gHandleDatabaseKey;
+  Handle->ProtocolKey = gHandleDatabaseKey;
 
   //
   // Release the lock and connect all drivers to UserHandle
@@ -36,7 +36,7 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 //
 
 #define MEMORY_MAP_SIGNATURE   SIGNATURE_32('m','m','a','p')
-typedef struct {
+typedef struct _MEMORY_MAP {
   UINTN           Signature;
   LIST_ENTRY      Link;
   BOOLEAN         FromPages;
@@ -47,6 +47,16 @@ typedef struct {
 
   UINT64          VirtualStart;
   UINT64          Attribute;
+
+  ///
+  /// Node of the balanced tree of memory map entries keyed by Start.
+  /// Height is 0 when the entry is not in the tree, and MaxFreeBytes is
+  /// the size of the largest EfiConventionalMemory entry in the subtree.
+  ///
+  struct _MEMORY_MAP  *Left;
+  struct _MEMORY_MAP  *Right;
+  UINTN               Height;
+  UINT64              MaxFreeBytes;
 } MEMORY_MAP;
 
 //
@@ -124,6 +134,19 @@ CoreFreePoolI (
 
 
 
+/**
+  Fills in the statistics of the pool magazines.
+
+  @param  Statistics             The memory profile record to fill in
+
+**/
+VOID
+CoreGetPoolCacheStatistics (
+  OUT MEMORY_PROFILE_POOL_CACHE  *Statistics
+  );
+
+
+
 /**
   Enter critical section by gaining lock on gMemoryLock.
 
@@ -151,4 +174,5 @@ CoreReleaseMemoryLock (
 extern EFI_LOCK           gMemoryLock;
 extern LIST_ENTRY         gMemoryMap;
 extern LIST_ENTRY         mGcdMemorySpaceMap;
+extern UINTN              mGcdMemorySpaceMapKey;
 #endif
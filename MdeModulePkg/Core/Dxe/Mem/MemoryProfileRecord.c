@@ -1197,6 +1197,7 @@ MemoryProfileGetDataSize (
                        );
     TotalSize += sizeof (MEMORY_PROFILE_ALLOC_INFO) * (UINTN) DriverInfoData->DriverInfo.AllocRecordCount;
   }
+  TotalSize += sizeof (MEMORY_PROFILE_POOL_CACHE);
 
   return TotalSize;
 }
@@ -1218,6 +1219,7 @@ MemoryProfileCopyData (
   MEMORY_PROFILE_CONTEXT_DATA       *ContextData;
   MEMORY_PROFILE_DRIVER_INFO_DATA   *DriverInfoData;
   MEMORY_PROFILE_ALLOC_INFO_DATA    *AllocInfoData;
+  MEMORY_PROFILE_POOL_CACHE         *PoolCache;
   LIST_ENTRY                        *DriverInfoList;
   LIST_ENTRY                        *DriverLink;
   LIST_ENTRY                        *AllocInfoList;
@@ -1261,6 +1263,13 @@ MemoryProfileCopyData (
 
     DriverInfo = (MEMORY_PROFILE_DRIVER_INFO *) ((UINTN) (DriverInfo + 1) + sizeof (MEMORY_PROFILE_ALLOC_INFO) * (UINTN) DriverInfo->AllocRecordCount);
   }
+
+  PoolCache = (MEMORY_PROFILE_POOL_CACHE *) DriverInfo;
+  ZeroMem (PoolCache, sizeof (MEMORY_PROFILE_POOL_CACHE));
+  PoolCache->Header.Signature = MEMORY_PROFILE_POOL_CACHE_SIGNATURE;
+  PoolCache->Header.Length    = sizeof (MEMORY_PROFILE_POOL_CACHE);
+  PoolCache->Header.Revision  = MEMORY_PROFILE_POOL_CACHE_REVISION;
+  CoreGetPoolCacheStatistics (PoolCache);
 }
 
 /**
@@ -35,6 +35,24 @@ typedef struct {
 //
 UINTN     mMemoryMapKey = 0;
 
+///
+/// mMemoryMapSnapshot - the descriptors built by the last successful CoreGetMemoryMap(),
+/// returned again as long as neither mMemoryMapKey nor mGcdMemorySpaceMapKey changes
+///
+EFI_MEMORY_DESCRIPTOR  *mMemoryMapSnapshot            = NULL;
+UINTN                  mMemoryMapSnapshotCapacity     = 0;
+UINTN                  mMemoryMapSnapshotSize         = 0;
+UINTN                  mMemoryMapSnapshotRequiredSize = 0;
+UINTN                  mMemoryMapSnapshotKey          = 0;
+UINTN                  mMemoryMapSnapshotGcdKey       = 0;
+BOOLEAN                mMemoryMapSnapshotValid        = FALSE;
+
+//
+// Number of spare descriptors in the snapshot buffer, so that a few allocations
+// made between two calls do not force the buffer to grow again
+//
+#define MEMORY_MAP_SNAPSHOT_SLACK  16
+
 #define MAX_MAP_DEPTH 6
 
 ///
@@ -51,6 +69,13 @@ UINTN         mFreeMapStack = 0;
 ///
 LIST_ENTRY   mFreeMemoryMapEntryList = INITIALIZE_LIST_HEAD_VARIABLE (mFreeMemoryMapEntryList);
 BOOLEAN      mMemoryTypeInformationInitialized = FALSE;
+///
+/// mMemoryMapTree - root of the balanced (AVL) tree of the gMemoryMap entries,
+/// keyed by Start, used to look up ranges and free pages without walking the list
+///
+MEMORY_MAP   *mMemoryMapTree = NULL;
+
+#define MEMORY_MAP_TREE_HEIGHT(Node)  (((Node) == NULL) ? 0 : (Node)->Height)
 
 EFI_MEMORY_TYPE_STATISTICS mMemoryTypeStatistics[EfiMaxMemoryType + 1] = {
   { 0, MAX_ADDRESS, 0, 0, EfiMaxMemoryType, TRUE,  FALSE },  // EfiReservedMemoryType
@@ -128,6 +153,393 @@ CoreReleaseMemoryLock (
 
 
 
+/**
+  Internal function.  Recomputes the height of a memory map tree node and
+  the size of the largest free range in its subtree from its children.
+
+  @param  Node                   The node to update
+
+**/
+VOID
+MemoryMapTreeUpdateNode (
+  IN OUT MEMORY_MAP      *Node
+  )
+{
+  Node->Height = MAX (MEMORY_MAP_TREE_HEIGHT (Node->Left), MEMORY_MAP_TREE_HEIGHT (Node->Right)) + 1;
+
+  Node->MaxFreeBytes = 0;
+  if (Node->Type == EfiConventionalMemory) {
+    Node->MaxFreeBytes = Node->End - Node->Start + 1;
+  }
+  if (Node->Left != NULL && Node->Left->MaxFreeBytes > Node->MaxFreeBytes) {
+    Node->MaxFreeBytes = Node->Left->MaxFreeBytes;
+  }
+  if (Node->Right != NULL && Node->Right->MaxFreeBytes > Node->MaxFreeBytes) {
+    Node->MaxFreeBytes = Node->Right->MaxFreeBytes;
+  }
+}
+
+/**
+  Internal function.  Rotates a memory map subtree to the left.
+
+  @param  Node                   The root of the subtree
+
+  @return The new root of the subtree
+
+**/
+MEMORY_MAP *
+MemoryMapTreeRotateLeft (
+  IN OUT MEMORY_MAP      *Node
+  )
+{
+  MEMORY_MAP  *Pivot;
+
+  Pivot       = Node->Right;
+  Node->Right = Pivot->Left;
+  Pivot->Left = Node;
+  MemoryMapTreeUpdateNode (Node);
+  MemoryMapTreeUpdateNode (Pivot);
+  return Pivot;
+}
+
+/**
+  Internal function.  Rotates a memory map subtree to the right.
+
+  @param  Node                   The root of the subtree
+
+  @return The new root of the subtree
+
+**/
+MEMORY_MAP *
+MemoryMapTreeRotateRight (
+  IN OUT MEMORY_MAP      *Node
+  )
+{
+  MEMORY_MAP  *Pivot;
+
+  Pivot        = Node->Left;
+  Node->Left   = Pivot->Right;
+  Pivot->Right = Node;
+  MemoryMapTreeUpdateNode (Node);
+  MemoryMapTreeUpdateNode (Pivot);
+  return Pivot;
+}
+
+/**
+  Internal function.  Updates a memory map tree node whose subtrees have
+  changed, and rotates it if the subtree heights differ by more than one.
+
+  @param  Node                   The root of the subtree
+
+  @return The new root of the subtree
+
+**/
+MEMORY_MAP *
+MemoryMapTreeBalance (
+  IN OUT MEMORY_MAP      *Node
+  )
+{
+  UINTN       LeftHeight;
+  UINTN       RightHeight;
+
+  MemoryMapTreeUpdateNode (Node);
+  LeftHeight  = MEMORY_MAP_TREE_HEIGHT (Node->Left);
+  RightHeight = MEMORY_MAP_TREE_HEIGHT (Node->Right);
+
+  if (LeftHeight > RightHeight + 1) {
+    if (MEMORY_MAP_TREE_HEIGHT (Node->Left->Left) < MEMORY_MAP_TREE_HEIGHT (Node->Left->Right)) {
+      Node->Left = MemoryMapTreeRotateLeft (Node->Left);
+    }
+    return MemoryMapTreeRotateRight (Node);
+  }
+
+  if (RightHeight > LeftHeight + 1) {
+    if (MEMORY_MAP_TREE_HEIGHT (Node->Right->Right) < MEMORY_MAP_TREE_HEIGHT (Node->Right->Left)) {
+      Node->Right = MemoryMapTreeRotateRight (Node->Right);
+    }
+    return MemoryMapTreeRotateLeft (Node);
+  }
+
+  return Node;
+}
+
+/**
+  Internal function.  Inserts an entry into a memory map subtree.
+
+  @param  Root                   The root of the subtree, or NULL
+  @param  Entry                  The entry to insert
+
+  @return The new root of the subtree
+
+**/
+MEMORY_MAP *
+MemoryMapTreeInsert (
+  IN OUT MEMORY_MAP      *Root,
+  IN OUT MEMORY_MAP      *Entry
+  )
+{
+  if (Root == NULL) {
+    Entry->Left  = NULL;
+    Entry->Right = NULL;
+    MemoryMapTreeUpdateNode (Entry);
+    return Entry;
+  }
+
+  ASSERT (Entry->Start != Root->Start);
+  if (Entry->Start < Root->Start) {
+    Root->Left = MemoryMapTreeInsert (Root->Left, Entry);
+  } else {
+    Root->Right = MemoryMapTreeInsert (Root->Right, Entry);
+  }
+  return MemoryMapTreeBalance (Root);
+}
+
+/**
+  Internal function.  Removes the entry with the lowest Start from a
+  memory map subtree.
+
+  @param  Root                   The root of the subtree
+  @param  Min                    Returns the removed entry
+
+  @return The new root of the subtree
+
+**/
+MEMORY_MAP *
+MemoryMapTreeRemoveMin (
+  IN OUT MEMORY_MAP      *Root,
+  OUT    MEMORY_MAP      **Min
+  )
+{
+  if (Root->Left == NULL) {
+    *Min = Root;
+    return Root->Right;
+  }
+  Root->Left = MemoryMapTreeRemoveMin (Root->Left, Min);
+  return MemoryMapTreeBalance (Root);
+}
+
+/**
+  Internal function.  Removes an entry from a memory map subtree.
+
+  @param  Root                   The root of the subtree
+  @param  Entry                  The entry to remove
+
+  @return The new root of the subtree
+
+**/
+MEMORY_MAP *
+MemoryMapTreeRemove (
+  IN OUT MEMORY_MAP      *Root,
+  IN     MEMORY_MAP      *Entry
+  )
+{
+  MEMORY_MAP  *Min;
+
+  ASSERT (Root != NULL);
+  if (Root == NULL) {
+    return NULL;
+  }
+
+  if (Entry->Start < Root->Start) {
+    Root->Left = MemoryMapTreeRemove (Root->Left, Entry);
+  } else if (Entry->Start > Root->Start) {
+    Root->Right = MemoryMapTreeRemove (Root->Right, Entry);
+  } else {
+    ASSERT (Root == Entry);
+    if (Root->Left == NULL) {
+      return Root->Right;
+    }
+    if (Root->Right == NULL) {
+      return Root->Left;
+    }
+    Root->Right = MemoryMapTreeRemoveMin (Root->Right, &Min);
+    Min->Left   = Root->Left;
+    Min->Right  = Root->Right;
+    Root        = Min;
+  }
+  return MemoryMapTreeBalance (Root);
+}
+
+/**
+  Internal function.  Adds a descriptor entry to the memory map tree.
+  The range of the entry must not change while it is in the tree.
+
+  @param  Entry                  The entry to add
+
+**/
+VOID
+InsertMemoryMapNode (
+  IN OUT MEMORY_MAP      *Entry
+  )
+{
+  mMemoryMapTree = MemoryMapTreeInsert (mMemoryMapTree, Entry);
+}
+
+/**
+  Internal function.  Removes a descriptor entry from the memory map tree,
+  if it is in the tree.
+
+  @param  Entry                  The entry to remove
+
+**/
+VOID
+RemoveMemoryMapNode (
+  IN OUT MEMORY_MAP      *Entry
+  )
+{
+  if (Entry->Height == 0) {
+    return;
+  }
+  mMemoryMapTree = MemoryMapTreeRemove (mMemoryMapTree, Entry);
+  Entry->Left   = NULL;
+  Entry->Right  = NULL;
+  Entry->Height = 0;
+}
+
+/**
+  Internal function.  Finds the descriptor entry covering an address.
+
+  @param  Address                The address to look up
+
+  @return The entry, or NULL if no entry covers the address
+
+**/
+MEMORY_MAP *
+FindMemoryMapEntry (
+  IN UINT64              Address
+  )
+{
+  MEMORY_MAP  *Node;
+  MEMORY_MAP  *Found;
+
+  //
+  // Find the entry with the highest Start at or below the address
+  //
+  Found = NULL;
+  Node  = mMemoryMapTree;
+  while (Node != NULL) {
+    if (Node->Start <= Address) {
+      Found = Node;
+      Node  = Node->Right;
+    } else {
+      Node  = Node->Left;
+    }
+  }
+
+  if (Found != NULL && Found->End >= Address) {
+    return Found;
+  }
+  return NULL;
+}
+
+/**
+  Internal function.  Finds the descriptor entry allocated from pages with
+  the lowest Start above an address.
+
+  @param  Address                The address to look up
+
+  @return The entry, or NULL if there is none
+
+**/
+MEMORY_MAP *
+FindNextMemoryMapEntryFromPages (
+  IN UINT64              Address
+  )
+{
+  MEMORY_MAP  *Node;
+  MEMORY_MAP  *Found;
+
+  do {
+    Found = NULL;
+    Node  = mMemoryMapTree;
+    while (Node != NULL) {
+      if (Node->Start > Address) {
+        Found = Node;
+        Node  = Node->Left;
+      } else {
+        Node  = Node->Right;
+      }
+    }
+    if (Found == NULL) {
+      return NULL;
+    }
+    Address = Found->Start;
+  } while (!Found->FromPages);
+
+  return Found;
+}
+
+/**
+  Internal function.  Finds the highest free range in a memory map subtree
+  that satisfies an allocation, using the same rules as CoreFindFreePagesI().
+  Subtrees without a large enough free range are skipped.
+
+  @param  Node                   The root of the subtree
+  @param  MaxAddress             The last address the range may use, end of a page
+  @param  MinAddress             The address that the range must be above
+  @param  NumberOfBytes          The size of the range
+  @param  Alignment              Bits to align with
+  @param  Target                 Returns the last address of the range found
+
+  @retval TRUE                   A range was found
+  @retval FALSE                  There is no suitable range in the subtree
+
+**/
+BOOLEAN
+MemoryMapTreeFindFreePages (
+  IN  MEMORY_MAP      *Node,
+  IN  UINT64          MaxAddress,
+  IN  UINT64          MinAddress,
+  IN  UINT64          NumberOfBytes,
+  IN  UINTN           Alignment,
+  OUT UINT64          *Target
+  )
+{
+  UINT64          DescStart;
+  UINT64          DescEnd;
+
+  if (Node == NULL || Node->MaxFreeBytes < NumberOfBytes) {
+    return FALSE;
+  }
+
+  //
+  // Ranges at higher addresses win, so look at them first
+  //
+  if (Node->Start < MaxAddress &&
+      MemoryMapTreeFindFreePages (Node->Right, MaxAddress, MinAddress, NumberOfBytes, Alignment, Target)) {
+    return TRUE;
+  }
+
+  if (Node->Type == EfiConventionalMemory && Node->Start < MaxAddress && Node->End >= MinAddress) {
+    DescStart = Node->Start;
+    DescEnd   = Node->End;
+
+    //
+    // If desc ends past max allowed address, clip the end
+    //
+    if (DescEnd >= MaxAddress) {
+      DescEnd = MaxAddress;
+    }
+
+    DescEnd = ((DescEnd + 1) & (~(Alignment - 1))) - 1;
+
+    if (DescEnd >= DescStart &&
+        DescEnd - DescStart + 1 >= NumberOfBytes &&
+        DescEnd - NumberOfBytes + 1 >= MinAddress) {
+      *Target = DescEnd;
+      return TRUE;
+    }
+  }
+
+  //
+  // All the ranges in the left subtree end below this one
+  //
+  if (Node->Start > MinAddress) {
+    return MemoryMapTreeFindFreePages (Node->Left, MaxAddress, MinAddress, NumberOfBytes, Alignment, Target);
+  }
+  return FALSE;
+}
+
 /**
   Internal function.  Removes a descriptor entry.
 
@@ -139,6 +551,7 @@ RemoveMemoryMapEntry (
   IN OUT MEMORY_MAP      *Entry
   )
 {
+  RemoveMemoryMapNode (Entry);
   RemoveEntryList (&Entry->Link);
   Entry->Link.ForwardLink = NULL;
 
@@ -170,7 +583,6 @@ CoreAddRange (
   IN UINT64                   Attribute
   )
 {
-  LIST_ENTRY        *Link;
   MEMORY_MAP        *Entry;
 
   ASSERT ((Start & EFI_PAGE_MASK) == 0);
@@ -217,25 +629,20 @@ CoreAddRange (
   // and the same Attribute
   //
 
-  Link = gMemoryMap.ForwardLink;
-  while (Link != &gMemoryMap) {
-    Entry = CR (Link, MEMORY_MAP, Link, MEMORY_MAP_SIGNATURE);
-    Link  = Link->ForwardLink;
-
-    if (Entry->Type != Type) {
-      continue;
-    }
-
-    if (Entry->Attribute != Attribute) {
-      continue;
-    }
-
-    if (Entry->End + 1 == Start) {
+  if (Start != 0) {
+    Entry = FindMemoryMapEntry (Start - 1);
+    if (Entry != NULL && Entry->End + 1 == Start &&
+        Entry->Type == Type && Entry->Attribute == Attribute) {
 
       Start = Entry->Start;
       RemoveMemoryMapEntry (Entry);
+    }
+  }
 
-    } else if (Entry->Start == End + 1) {
+  if (End != MAX_UINT64) {
+    Entry = FindMemoryMapEntry (End + 1);
+    if (Entry != NULL && Entry->Start == End + 1 &&
+        Entry->Type == Type && Entry->Attribute == Attribute) {
 
       End = Entry->End;
       RemoveMemoryMapEntry (Entry);
@@ -254,6 +661,7 @@ CoreAddRange (
   mMapStack[mMapDepth].VirtualStart  = 0;
   mMapStack[mMapDepth].Attribute     = Attribute;
   InsertTailList (&gMemoryMap, &mMapStack[mMapDepth].Link);
+  InsertMemoryMapNode (&mMapStack[mMapDepth]);
 
   mMapDepth += 1;
   ASSERT (mMapDepth < MAX_MAP_DEPTH);
@@ -356,6 +764,7 @@ CoreFreeMemoryMapStack (
       //
       // Move this entry to general memory
       //
+      RemoveMemoryMapNode (&mMapStack[mMapDepth]);
       RemoveEntryList (&mMapStack[mMapDepth].Link);
       mMapStack[mMapDepth].Link.ForwardLink = NULL;
 
@@ -363,16 +772,13 @@ CoreFreeMemoryMapStack (
       Entry->FromPages = TRUE;
 
       //
-      // Find insertion location
+      // Find insertion location, keeping the entries from pages sorted
       //
-      for (Link2 = gMemoryMap.ForwardLink; Link2 != &gMemoryMap; Link2 = Link2->ForwardLink) {
-        Entry2 = CR (Link2, MEMORY_MAP, Link, MEMORY_MAP_SIGNATURE);
-        if (Entry2->FromPages && Entry2->Start > Entry->Start) {
-          break;
-        }
-      }
+      Entry2 = FindNextMemoryMapEntryFromPages (Entry->Start);
+      Link2  = (Entry2 == NULL) ? &gMemoryMap : &Entry2->Link;
 
       InsertTailList (Link2, &Entry->Link);
+      InsertMemoryMapNode (Entry);
 
     } else {
       //
@@ -672,6 +1078,12 @@ CoreAddMemoryDescriptor (
     }
   }
 
+  //
+  // The memory type bins are now in place, which changes the types reported
+  // for free memory inside them
+  //
+  mMemoryMapSnapshotValid = FALSE;
+
   mMemoryTypeInformationInitialized = TRUE;
 }
 
@@ -712,7 +1124,6 @@ CoreConvertPagesEx (
   UINT64          RangeEnd;
   UINT64          Attribute;
   EFI_MEMORY_TYPE MemType;
-  LIST_ENTRY      *Link;
   MEMORY_MAP      *Entry;
 
   Entry = NULL;
@@ -738,15 +1149,9 @@ CoreConvertPagesEx (
     //
     // Find the entry that the covers the range
     //
-    for (Link = gMemoryMap.ForwardLink; Link != &gMemoryMap; Link = Link->ForwardLink) {
-      Entry = CR (Link, MEMORY_MAP, Link, MEMORY_MAP_SIGNATURE);
-
-      if (Entry->Start <= Start && Entry->End > Start) {
-        break;
-      }
-    }
+    Entry = FindMemoryMapEntry (Start);
 
-    if (Link == &gMemoryMap) {
+    if (Entry == NULL) {
       DEBUG ((DEBUG_ERROR | DEBUG_PAGE, "ConvertPages: failed to find range %lx - %lx\n", Start, End));
       return EFI_NOT_FOUND;
     }
@@ -804,8 +1209,10 @@ CoreConvertPagesEx (
     }
 
     //
-    // Pull range out of descriptor
+    // Pull range out of descriptor.  The entry has to leave the tree
+    // while its range changes.
     //
+    RemoveMemoryMapNode (Entry);
     if (Entry->Start == Start) {
 
       //
@@ -842,6 +1249,7 @@ CoreConvertPagesEx (
 
       Entry->End = Start - 1;
       ASSERT (Entry->Start < Entry->End);
+      InsertMemoryMapNode (Entry);
 
       Entry = &mMapStack[mMapDepth];
       InsertTailList (&gMemoryMap, &Entry->Link);
@@ -868,6 +1276,8 @@ CoreConvertPagesEx (
     if (Entry->Start == Entry->End + 1) {
       RemoveMemoryMapEntry (Entry);
       Entry = NULL;
+    } else {
+      InsertMemoryMapNode (Entry);
     }
 
     //
@@ -987,11 +1397,6 @@ CoreFindFreePagesI (
 {
   UINT64          NumberOfBytes;
   UINT64          Target;
-  UINT64          DescStart;
-  UINT64          DescEnd;
-  UINT64          DescNumberOfBytes;
-  LIST_ENTRY      *Link;
-  MEMORY_MAP      *Entry;
 
   if ((MaxAddress < EFI_PAGE_MASK) ||(NumberOfPages == 0)) {
     return 0;
@@ -1022,62 +1427,12 @@ CoreFindFreePagesI (
   NumberOfBytes = LShiftU64 (NumberOfPages, EFI_PAGE_SHIFT);
   Target = 0;
 
-  for (Link = gMemoryMap.ForwardLink; Link != &gMemoryMap; Link = Link->ForwardLink) {
-    Entry = CR (Link, MEMORY_MAP, Link, MEMORY_MAP_SIGNATURE);
-
-    //
-    // If it's not a free entry, don't bother with it
-    //
-    if (Entry->Type != EfiConventionalMemory) {
-      continue;
-    }
-
-    DescStart = Entry->Start;
-    DescEnd = Entry->End;
-
-    //
-    // If desc is past max allowed address or below min allowed address, skip it
-    //
-    if ((DescStart >= MaxAddress) || (DescEnd < MinAddress)) {
-      continue;
-    }
-
-    //
-    // If desc ends past max allowed address, clip the end
-    //
-    if (DescEnd >= MaxAddress) {
-      DescEnd = MaxAddress;
-    }
-
-    DescEnd = ((DescEnd + 1) & (~(Alignment - 1))) - 1;
-
-    // Skip if DescEnd is less than DescStart after alignment clipping
-    if (DescEnd < DescStart) {
-      continue;
-    }
-
-    //
-    // Compute the number of bytes we can used from this
-    // descriptor, and see it's enough to satisfy the request
-    //
-    DescNumberOfBytes = DescEnd - DescStart + 1;
-
-    if (DescNumberOfBytes >= NumberOfBytes) {
-      //
-      // If the start of the allocated range is below the min address allowed, skip it
-      //
-      if ((DescEnd - NumberOfBytes + 1) < MinAddress) {
-        continue;
-      }
-
-      //
-      // If this is the best match so far remember it
-      //
-      if (DescEnd > Target) {
-        Target = DescEnd;
-      }
-    }
-  }
+  //
+  // Find the free range with the highest end address that fits.  Free
+  // ranges do not overlap, so this is the first one found going down
+  // from MaxAddress.
+  //
+  MemoryMapTreeFindFreePages (mMemoryMapTree, MaxAddress, MinAddress, NumberOfBytes, Alignment, &Target);
 
   //
   // If this is a grow down, adjust target to be the allocation base
@@ -1333,7 +1688,6 @@ CoreInternalFreePages (
   )
 {
   EFI_STATUS      Status;
-  LIST_ENTRY      *Link;
   MEMORY_MAP      *Entry;
   UINTN           Alignment;
 
@@ -1345,14 +1699,8 @@ CoreInternalFreePages (
   //
   // Find the entry that the covers the range
   //
-  Entry = NULL;
-  for (Link = gMemoryMap.ForwardLink; Link != &gMemoryMap; Link = Link->ForwardLink) {
-    Entry = CR(Link, MEMORY_MAP, Link, MEMORY_MAP_SIGNATURE);
-    if (Entry->Start <= Memory && Entry->End > Memory) {
-        break;
-    }
-  }
-  if (Link == &gMemoryMap) {
+  Entry = FindMemoryMapEntry (Memory);
+  if (Entry == NULL) {
     Status = EFI_NOT_FOUND;
     goto Done;
   }
@@ -1496,6 +1844,44 @@ MergeMemoryMapDescriptor (
   return NEXT_MEMORY_DESCRIPTOR (MemoryMapDescriptor, DescriptorSize);
 }
 
+/**
+  Internal function.  Makes the buffer holding the memory map snapshot at least
+  the given size.  Allocating the buffer changes the memory map, so the snapshot
+  is only valid again after the map has been rebuilt.
+
+  @param  Capacity               The size, in bytes, the buffer must hold
+
+**/
+STATIC
+VOID
+CoreGrowMemoryMapSnapshot (
+  IN UINTN                      Capacity
+  )
+{
+  EFI_MEMORY_DESCRIPTOR  *NewSnapshot;
+  EFI_MEMORY_DESCRIPTOR  *OldSnapshot;
+
+  NewSnapshot = AllocatePool (Capacity);
+  if (NewSnapshot == NULL) {
+    return;
+  }
+
+  CoreAcquireMemoryLock ();
+  if (Capacity > mMemoryMapSnapshotCapacity) {
+    OldSnapshot                = mMemoryMapSnapshot;
+    mMemoryMapSnapshot         = NewSnapshot;
+    mMemoryMapSnapshotCapacity = Capacity;
+    mMemoryMapSnapshotValid    = FALSE;
+  } else {
+    OldSnapshot                = NewSnapshot;
+  }
+  CoreReleaseMemoryLock ();
+
+  if (OldSnapshot != NULL) {
+    FreePool (OldSnapshot);
+  }
+}
+
 /**
   This function returns a copy of the current memory map. The map is an array of
   memory descriptors, each of which describes a contiguous block of memory.
@@ -1556,21 +1942,6 @@ CoreGetMemoryMap (
 
   CoreAcquireGcdMemoryLock ();
 
-  //
-  // Count the number of Reserved and runtime MMIO entries
-  // And, count the number of Persistent entries.
-  //
-  NumberOfEntries = 0;
-  for (Link = mGcdMemorySpaceMap.ForwardLink; Link != &mGcdMemorySpaceMap; Link = Link->ForwardLink) {
-    GcdMapEntry = CR (Link, EFI_GCD_MAP_ENTRY, Link, EFI_GCD_MAP_SIGNATURE);
-    if ((GcdMapEntry->GcdMemoryType == EfiGcdMemoryTypePersistentMemory) || 
-        (GcdMapEntry->GcdMemoryType == EfiGcdMemoryTypeReserved) ||
-        ((GcdMapEntry->GcdMemoryType == EfiGcdMemoryTypeMemoryMappedIo) &&
-        ((GcdMapEntry->Attributes & EFI_MEMORY_RUNTIME) == EFI_MEMORY_RUNTIME))) {
-      NumberOfEntries ++;
-    }
-  }
-
   Size = sizeof (EFI_MEMORY_DESCRIPTOR);
 
   //
@@ -1590,6 +1961,46 @@ CoreGetMemoryMap (
 
   CoreAcquireMemoryLock ();
 
+  //
+  // If neither the memory map nor the GCD memory space map changed since the
+  // map was last built, return a copy of that map
+  //
+  if (mMemoryMapSnapshotValid &&
+      mMemoryMapSnapshotKey    == mMemoryMapKey &&
+      mMemoryMapSnapshotGcdKey == mGcdMemorySpaceMapKey) {
+    BufferSize = mMemoryMapSnapshotRequiredSize;
+    if (*MemoryMapSize < BufferSize) {
+      Status = EFI_BUFFER_TOO_SMALL;
+      goto Done;
+    }
+
+    if (MemoryMap == NULL) {
+      Status = EFI_INVALID_PARAMETER;
+      goto Done;
+    }
+
+    CopyMem (MemoryMap, mMemoryMapSnapshot, mMemoryMapSnapshotSize);
+    ZeroMem ((UINT8 *)MemoryMap + mMemoryMapSnapshotSize, BufferSize - mMemoryMapSnapshotSize);
+    BufferSize = mMemoryMapSnapshotSize;
+    Status = EFI_SUCCESS;
+    goto Done;
+  }
+
+  //
+  // Count the number of Reserved and runtime MMIO entries
+  // And, count the number of Persistent entries.
+  //
+  NumberOfEntries = 0;
+  for (Link = mGcdMemorySpaceMap.ForwardLink; Link != &mGcdMemorySpaceMap; Link = Link->ForwardLink) {
+    GcdMapEntry = CR (Link, EFI_GCD_MAP_ENTRY, Link, EFI_GCD_MAP_SIGNATURE);
+    if ((GcdMapEntry->GcdMemoryType == EfiGcdMemoryTypePersistentMemory) || 
+        (GcdMapEntry->GcdMemoryType == EfiGcdMemoryTypeReserved) ||
+        ((GcdMapEntry->GcdMemoryType == EfiGcdMemoryTypeMemoryMappedIo) &&
+        ((GcdMapEntry->Attributes & EFI_MEMORY_RUNTIME) == EFI_MEMORY_RUNTIME))) {
+      NumberOfEntries ++;
+    }
+  }
+
   //
   // Compute the buffer size needed to fit the entire map
   //
@@ -1750,6 +2161,18 @@ CoreGetMemoryMap (
     }
   }
 
+  //
+  // Keep a copy of the map for the following calls, if it fits in the snapshot buffer
+  //
+  if ((UINTN)((UINT8 *)MemoryMap - (UINT8 *)MemoryMapStart) <= mMemoryMapSnapshotCapacity) {
+    mMemoryMapSnapshotRequiredSize = BufferSize;
+    mMemoryMapSnapshotSize         = (UINT8 *)MemoryMap - (UINT8 *)MemoryMapStart;
+    mMemoryMapSnapshotKey          = mMemoryMapKey;
+    mMemoryMapSnapshotGcdKey       = mGcdMemorySpaceMapKey;
+    mMemoryMapSnapshotValid        = TRUE;
+    CopyMem (mMemoryMapSnapshot, MemoryMapStart, mMemoryMapSnapshotSize);
+  }
+
   //
   // Compute the size of the buffer actually used after all memory map descriptor merge operations
   //
@@ -1774,6 +2197,97 @@ Done:
   return Status;
 }
 
+/**
+  Memory map change notification.  Makes room for the current memory map in the
+  snapshot buffer, so that CoreGetMemoryMap() itself never allocates memory.
+
+  @param  Event                  The Event that is being processed
+  @param  Context                Event Context
+
+**/
+STATIC
+VOID
+EFIAPI
+CoreMemoryMapSnapshotNotify (
+  IN EFI_EVENT                  Event,
+  IN VOID                       *Context
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       MemoryMapSize;
+  UINTN       MapKey;
+  UINTN       DescriptorSize;
+  UINT32      DescriptorVersion;
+
+  MemoryMapSize = 0;
+  Status = CoreGetMemoryMap (&MemoryMapSize, NULL, &MapKey, &DescriptorSize, &DescriptorVersion);
+  if (Status == EFI_BUFFER_TOO_SMALL && MemoryMapSize > mMemoryMapSnapshotCapacity) {
+    //
+    // Growing the buffer changes the memory map and signals this notification
+    // again, which the spare descriptors then absorb
+    //
+    CoreGrowMemoryMapSnapshot (MemoryMapSize + MEMORY_MAP_SNAPSHOT_SLACK * DescriptorSize);
+  }
+}
+
+/**
+  End of DXE notification.  Sizes the snapshot buffer for the memory map, and
+  keeps it sized on every memory map change from then on, which is when the OS
+  loaders call GetMemoryMap() repeatedly.
+
+  @param  Event                  The Event that is being processed
+  @param  Context                Event Context
+
+**/
+STATIC
+VOID
+EFIAPI
+CoreMemoryMapSnapshotOnEndOfDxe (
+  IN EFI_EVENT                  Event,
+  IN VOID                       *Context
+  )
+{
+  EFI_STATUS  Status;
+  EFI_EVENT   MemoryMapChangeEvent;
+
+  CoreCloseEvent (Event);
+
+  Status = CoreCreateEventEx (
+             EVT_NOTIFY_SIGNAL,
+             TPL_CALLBACK,
+             CoreMemoryMapSnapshotNotify,
+             NULL,
+             &gEfiEventMemoryMapChangeGuid,
+             &MemoryMapChangeEvent
+             );
+  ASSERT_EFI_ERROR (Status);
+
+  CoreMemoryMapSnapshotNotify (MemoryMapChangeEvent, NULL);
+}
+
+/**
+  Initialize the memory map snapshot support.
+
+**/
+VOID
+CoreInitializeMemoryMapSnapshot (
+  VOID
+  )
+{
+  EFI_STATUS  Status;
+  EFI_EVENT   EndOfDxeEvent;
+
+  Status = CoreCreateEventEx (
+             EVT_NOTIFY_SIGNAL,
+             TPL_CALLBACK,
+             CoreMemoryMapSnapshotOnEndOfDxe,
+             NULL,
+             &gEfiEndOfDxeEventGroupGuid,
+             &EndOfDxeEvent
+             );
+  ASSERT_EFI_ERROR (Status);
+}
+
 
 /**
   Internal function.  Used by the pool functions to allocate pages
@@ -46,6 +46,22 @@ typedef struct {
 #define HEAD_TO_TAIL(a)   \
   ((POOL_TAIL *) (((CHAR8 *) (a)) + (a)->Size - sizeof(POOL_TAIL)));
 
+//
+// Freed blocks of the smallest size classes are kept in per memory type
+// magazines, so that they can be handed out again without going through
+// the free lists.  A cached block keeps its POOL_HEAD, with the signature
+// changed, and links to the next cached block through its data.
+//
+#define POOL_CACHED_SIGNATURE SIGNATURE_32('p','c','h','0')
+
+#define POOL_MAGAZINE_CLASSES 5
+#define POOL_MAGAZINE_DEPTH   32
+
+typedef struct {
+  POOL_HEAD       *Top;
+  UINTN           Count;
+} POOL_MAGAZINE;
+
 //
 // Each element is the sum of the 2 previous ones: this allows us to migrate
 // blocks between bins by splitting them up, while not wasting too much memory
@@ -85,6 +101,36 @@ POOL            mPoolHead[EfiMaxMemoryType];
 //
 LIST_ENTRY      mPoolHeadList = INITIALIZE_LIST_HEAD_VARIABLE (mPoolHeadList);
 
+//
+// Magazines of the small size classes for each memory type, and their statistics.
+// mPoolCacheHitCount  - Number of allocations served from a magazine
+// mPoolCacheMissCount - Number of allocations of a magazine size class that found it empty
+// mPoolWastedBytes    - Bytes lost to rounding up the allocations to their size class
+// mPoolCachedBytes    - Bytes held in the magazines
+//
+POOL_MAGAZINE   mPoolMagazine[EfiMaxMemoryType][POOL_MAGAZINE_CLASSES];
+UINT64          mPoolCacheHitCount  = 0;
+UINT64          mPoolCacheMissCount = 0;
+UINT64          mPoolWastedBytes    = 0;
+UINT64          mPoolCachedBytes    = 0;
+
+/**
+  Internal function to free a pool entry.
+  Caller must have the memory lock held
+
+  @param  Buffer                 The allocated pool entry to free
+  @param  Cache                  Whether the entry may be kept in a magazine
+
+  @retval EFI_INVALID_PARAMETER  Buffer not valid
+  @retval EFI_SUCCESS            Buffer successfully freed.
+
+**/
+EFI_STATUS
+CoreFreePoolWorker (
+  IN VOID       *Buffer,
+  IN BOOLEAN    Cache
+  );
+
 /**
   Get pool size table index from the specified size.
 
@@ -109,6 +155,151 @@ GetPoolIndexFromSize (
   return MAX_POOL_LIST;
 }
 
+/**
+  Puts a freed pool block into the magazine of its memory type and size class.
+  Caller must have the memory lock held
+
+  @param  Head                   The pool block, already accounted as freed
+  @param  Index                  The size class of the block
+
+  @retval TRUE                   The block is now in the magazine
+  @retval FALSE                  The magazine is full
+
+**/
+BOOLEAN
+CorePoolMagazinePush (
+  IN POOL_HEAD  *Head,
+  IN UINTN      Index
+  )
+{
+  POOL_MAGAZINE   *Magazine;
+
+  Magazine = &mPoolMagazine[Head->Type][Index];
+  if (Magazine->Count >= POOL_MAGAZINE_DEPTH) {
+    return FALSE;
+  }
+
+  Head->Signature = POOL_CACHED_SIGNATURE;
+  DEBUG_CLEAR_MEMORY (Head->Data, LIST_TO_SIZE (Index) - SIZE_OF_POOL_HEAD);
+  *(POOL_HEAD **) Head->Data = Magazine->Top;
+  Magazine->Top = Head;
+  Magazine->Count++;
+  mPoolCachedBytes += LIST_TO_SIZE (Index);
+  return TRUE;
+}
+
+/**
+  Takes a pool block out of the magazine of a memory type and size class.
+  When DEBUG_CLEAR_MEMORY is enabled, the block is checked for writes
+  made after it was freed.
+  Caller must have the memory lock held
+
+  @param  PoolType               The memory type of the magazine
+  @param  Index                  The size class of the magazine
+
+  @return The pool block, or NULL if the magazine is empty
+
+**/
+POOL_HEAD *
+CorePoolMagazinePop (
+  IN EFI_MEMORY_TYPE  PoolType,
+  IN UINTN            Index
+  )
+{
+  POOL_MAGAZINE   *Magazine;
+  POOL_HEAD       *Head;
+  UINT8           *Byte;
+  UINT8           *End;
+
+  Magazine = &mPoolMagazine[PoolType][Index];
+  Head = Magazine->Top;
+  if (Head == NULL) {
+    return NULL;
+  }
+
+  ASSERT (Head->Signature == POOL_CACHED_SIGNATURE);
+  Magazine->Top = *(POOL_HEAD **) Head->Data;
+  Magazine->Count--;
+  mPoolCachedBytes -= LIST_TO_SIZE (Index);
+
+  if (DebugClearMemoryEnabled ()) {
+    End = (UINT8 *) Head + LIST_TO_SIZE (Index);
+    for (Byte = (UINT8 *) Head->Data + sizeof (POOL_HEAD *); Byte < End; Byte++) {
+      if (*Byte != PcdGet8 (PcdDebugClearMemoryValue)) {
+        DEBUG ((DEBUG_ERROR, "AllocatePool: freed pool %p was written at offset %x\n", Head->Data, (UINTN) (Byte - (UINT8 *) Head->Data)));
+        ASSERT (FALSE);
+        break;
+      }
+    }
+  }
+
+  return Head;
+}
+
+/**
+  Returns the blocks held in all magazines to the free lists, so that
+  pages they share with other free blocks can be freed.
+  Caller must have the memory lock held
+
+  @retval TRUE                   Some blocks were returned
+  @retval FALSE                  All magazines were empty
+
+**/
+BOOLEAN
+CoreFlushPoolMagazines (
+  VOID
+  )
+{
+  POOL_HEAD   *Head;
+  POOL_TAIL   *Tail;
+  UINTN       Type;
+  UINTN       Index;
+  BOOLEAN     Flushed;
+
+  ASSERT_LOCKED (&gMemoryLock);
+
+  Flushed = FALSE;
+  for (Type = 0; Type < EfiMaxMemoryType; Type++) {
+    for (Index = 0; Index < POOL_MAGAZINE_CLASSES; Index++) {
+      while ((Head = CorePoolMagazinePop ((EFI_MEMORY_TYPE) Type, Index)) != NULL) {
+        //
+        // Turn the block back into an allocated one spanning its size class
+        //
+        Head->Signature = POOL_HEAD_SIGNATURE;
+        Head->Size      = LIST_TO_SIZE (Index);
+        Tail            = HEAD_TO_TAIL (Head);
+        Tail->Signature = POOL_TAIL_SIGNATURE;
+        Tail->Size      = Head->Size;
+        mPoolHead[Type].Used += Head->Size;
+
+        CoreFreePoolWorker (Head->Data, FALSE);
+        Flushed = TRUE;
+      }
+    }
+  }
+
+  return Flushed;
+}
+
+/**
+  Fills in the statistics of the pool magazines.
+
+  @param  Statistics             The memory profile record to fill in
+
+**/
+VOID
+CoreGetPoolCacheStatistics (
+  OUT MEMORY_PROFILE_POOL_CACHE  *Statistics
+  )
+{
+  CoreAcquireMemoryLock ();
+  Statistics->HitCount    = mPoolCacheHitCount;
+  Statistics->MissCount   = mPoolCacheMissCount;
+  Statistics->WastedBytes = mPoolWastedBytes;
+  Statistics->CachedBytes = mPoolCachedBytes;
+  CoreReleaseMemoryLock ();
+}
+
 /**
   Called to initialize the pool.
 
@@ -245,6 +436,9 @@ CoreInternalAllocatePool (
   }
 
   *Buffer = CoreAllocatePoolI (PoolType, Size);
+  if (*Buffer == NULL && CoreFlushPoolMagazines ()) {
+    *Buffer = CoreAllocatePoolI (PoolType, Size);
+  }
   CoreReleaseMemoryLock ();
   return (*Buffer != NULL) ? EFI_SUCCESS : EFI_OUT_OF_RESOURCES;
 }
@@ -304,6 +498,7 @@ CoreAllocatePoolI (
   CHAR8       *NewPage;
   VOID        *Buffer;
   UINTN       Index;
+  UINTN       ListIndex;
   UINTN       FSize;
   UINTN       Offset, MaxOffset;
   UINTN       NoPages;
@@ -334,12 +529,25 @@ CoreAllocatePoolI (
 
   Size += POOL_OVERHEAD;
   Index = SIZE_TO_LIST(Size);
+  ListIndex = Index;
   Pool = LookupPoolHead (PoolType);
   if (Pool== NULL) {
     return NULL;
   }
   Head = NULL;
 
+  //
+  // Serve small allocations from the magazine of their size class (fast)
+  //
+  if (Index < POOL_MAGAZINE_CLASSES && (UINT32) PoolType < EfiMaxMemoryType) {
+    Head = CorePoolMagazinePop (PoolType, Index);
+    if (Head != NULL) {
+      mPoolCacheHitCount++;
+      goto Done;
+    }
+    mPoolCacheMissCount++;
+  }
+
   //
   // If allocation is over max size, just allocate pages for the request
   // (slow)
@@ -445,6 +653,9 @@ Done:
     // Account the allocation
     //
     Pool->Used += Size;
+    if (ListIndex < SIZE_TO_LIST (Granularity)) {
+      mPoolWastedBytes += LIST_TO_SIZE (ListIndex) - Size;
+    }
 
   } else {
     DEBUG ((DEBUG_ERROR | DEBUG_POOL, "AllocatePool: failed to allocate %ld bytes\n", (UINT64) Size));
@@ -520,6 +731,26 @@ EFI_STATUS
 CoreFreePoolI (
   IN VOID       *Buffer
   )
+{
+  return CoreFreePoolWorker (Buffer, TRUE);
+}
+
+/**
+  Internal function to free a pool entry.
+  Caller must have the memory lock held
+
+  @param  Buffer                 The allocated pool entry to free
+  @param  Cache                  Whether the entry may be kept in a magazine
+
+  @retval EFI_INVALID_PARAMETER  Buffer not valid
+  @retval EFI_SUCCESS            Buffer successfully freed.
+
+**/
+EFI_STATUS
+CoreFreePoolWorker (
+  IN VOID       *Buffer,
+  IN BOOLEAN    Cache
+  )
 {
   POOL        *Pool;
   POOL_HEAD   *Head;
@@ -587,6 +818,19 @@ CoreFreePoolI (
   // Determine the pool list
   //
   Index = SIZE_TO_LIST(Size);
+  if (Index < SIZE_TO_LIST (Granularity)) {
+    mPoolWastedBytes -= LIST_TO_SIZE (Index) - Size;
+  }
+
+  //
+  // Keep small blocks in the magazine of their size class (fast)
+  //
+  if (Cache && Index < POOL_MAGAZINE_CLASSES && (UINT32) Head->Type < EfiMaxMemoryType) {
+    if (CorePoolMagazinePush (Head, Index)) {
+      return EFI_SUCCESS;
+    }
+  }
+
   DEBUG_CLEAR_MEMORY (Head, Size);
 
   //
@@ -82,6 +82,23 @@ EFI_LOCK           mPropertiesTableLock = EFI_INITIALIZE_LOCK_VARIABLE (TPL_NOTI
 
 BOOLEAN            mPropertiesTableEnable;
 
+//
+// The memory map last returned by CoreGetMemoryMap(), and the same map after the
+// PE code/data split.  The split map is returned again as long as neither the
+// image records nor the map returned by CoreGetMemoryMap() change.
+//
+EFI_MEMORY_DESCRIPTOR  *mSplitMemoryMapSource      = NULL;
+UINTN                  mSplitMemoryMapSourceSize   = 0;
+EFI_MEMORY_DESCRIPTOR  *mSplitMemoryMap            = NULL;
+UINTN                  mSplitMemoryMapSize         = 0;
+UINTN                  mSplitMemoryMapCapacity     = 0;
+BOOLEAN                mSplitMemoryMapValid        = FALSE;
+
+//
+// Number of spare descriptors in the split map buffers
+//
+#define SPLIT_MEMORY_MAP_SLACK  16
+
 //
 // Below functions are for MemoryMap
 //
@@ -724,6 +741,50 @@ SplitTable (
   return ;
 }
 
+/**
+  Makes the buffers holding the split memory map and its source at least
+  the given size.
+
+  @param  Capacity               The size, in bytes, each buffer must hold
+**/
+STATIC
+VOID
+GrowSplitMemoryMap (
+  IN UINTN                      Capacity
+  )
+{
+  EFI_MEMORY_DESCRIPTOR  *NewSource;
+  EFI_MEMORY_DESCRIPTOR  *NewMap;
+  EFI_MEMORY_DESCRIPTOR  *OldMap;
+
+  NewSource = AllocatePool (Capacity);
+  NewMap    = AllocatePool (Capacity);
+  if (NewSource == NULL || NewMap == NULL) {
+    goto Done;
+  }
+
+  CoreAcquirePropertiesTableLock ();
+  if (Capacity > mSplitMemoryMapCapacity) {
+    OldMap                  = mSplitMemoryMapSource;
+    mSplitMemoryMapSource   = NewSource;
+    NewSource               = OldMap;
+    OldMap                  = mSplitMemoryMap;
+    mSplitMemoryMap         = NewMap;
+    NewMap                  = OldMap;
+    mSplitMemoryMapCapacity = Capacity;
+    mSplitMemoryMapValid    = FALSE;
+  }
+  CoreReleasePropertiesTableLock ();
+
+Done:
+  if (NewSource != NULL) {
+    FreePool (NewSource);
+  }
+  if (NewMap != NULL) {
+    FreePool (NewMap);
+  }
+}
+
 /**
   This function for GetMemoryMap() with properties table capability.
 
@@ -797,18 +858,68 @@ CoreGetMemoryMapPropertiesTable (
       // Need update status to buffer too small
       //
       Status = EFI_BUFFER_TOO_SMALL;
+    } else if (mSplitMemoryMapValid &&
+               *MemoryMapSize == mSplitMemoryMapSourceSize &&
+               CompareMem (MemoryMap, mSplitMemoryMapSource, *MemoryMapSize) == 0) {
+      //
+      // Same map as last time, return the split done then
+      //
+      CopyMem (MemoryMap, mSplitMemoryMap, mSplitMemoryMapSize);
+      *MemoryMapSize = mSplitMemoryMapSize;
     } else {
+      mSplitMemoryMapValid = FALSE;
+      mSplitMemoryMapSourceSize = *MemoryMapSize;
+      if (mSplitMemoryMapSourceSize <= mSplitMemoryMapCapacity) {
+        CopyMem (mSplitMemoryMapSource, MemoryMap, mSplitMemoryMapSourceSize);
+      }
+
       //
       // Split PE code/data
       //
       SplitTable (MemoryMapSize, MemoryMap, *DescriptorSize);
+
+      if (mSplitMemoryMapSourceSize <= mSplitMemoryMapCapacity && *MemoryMapSize <= mSplitMemoryMapCapacity) {
+        CopyMem (mSplitMemoryMap, MemoryMap, *MemoryMapSize);
+        mSplitMemoryMapSize  = *MemoryMapSize;
+        mSplitMemoryMapValid = TRUE;
+      }
     }
   }
 
   CoreReleasePropertiesTableLock ();
+
   return Status;
 }
 
+/**
+  Memory map change notification.  Makes room for the current split memory map
+  in the split map buffers, so that CoreGetMemoryMapPropertiesTable() itself
+  never allocates memory.
+
+  @param  Event                  The Event that is being processed
+  @param  Context                Event Context
+**/
+STATIC
+VOID
+EFIAPI
+SplitMemoryMapNotify (
+  IN EFI_EVENT                  Event,
+  IN VOID                       *Context
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       MemoryMapSize;
+  UINTN       MapKey;
+  UINTN       DescriptorSize;
+  UINT32      DescriptorVersion;
+
+  MemoryMapSize = 0;
+  Status = CoreGetMemoryMapPropertiesTable (&MemoryMapSize, NULL, &MapKey, &DescriptorSize, &DescriptorVersion);
+  if (Status == EFI_BUFFER_TOO_SMALL && MemoryMapSize > mSplitMemoryMapCapacity) {
+    GrowSplitMemoryMap (MemoryMapSize + SPLIT_MEMORY_MAP_SLACK * DescriptorSize);
+  }
+}
+
 //
 // Below functions are for ImageRecord
 //
@@ -1246,6 +1357,7 @@ InsertImageRecord (
 
   InsertTailList (&mImagePropertiesPrivateData.ImageRecordList, &ImageRecord->Link);
   mImagePropertiesPrivateData.ImageRecordCount++;
+  mSplitMemoryMapValid = FALSE;
 
   SortImageRecord ();
 
@@ -1335,6 +1447,7 @@ RemoveImageRecord (
   RemoveEntryList (&ImageRecord->Link);
   FreePool (ImageRecord);
   mImagePropertiesPrivateData.ImageRecordCount--;
+  mSplitMemoryMapValid = FALSE;
 }
 
 
@@ -1353,6 +1466,7 @@ InstallPropertiesTable (
 {
   if (PcdGetBool (PcdPropertiesTableEnable)) {
     EFI_STATUS  Status;
+    EFI_EVENT   MemoryMapChangeEvent;
 
     Status = gBS->InstallConfigurationTable (&gEfiPropertiesTableGuid, &mPropertiesTable);
     ASSERT_EFI_ERROR (Status);
@@ -1373,6 +1487,22 @@ InstallPropertiesTable (
     DumpImageRecord ();
 
     mPropertiesTableEnable = TRUE;
+
+    //
+    // Size the split map buffers now and on every memory map change, as the
+    // OS loaders are about to call GetMemoryMap() repeatedly
+    //
+    Status = gBS->CreateEventEx (
+                    EVT_NOTIFY_SIGNAL,
+                    TPL_CALLBACK,
+                    SplitMemoryMapNotify,
+                    NULL,
+                    &gEfiEventMemoryMapChangeGuid,
+                    &MemoryMapChangeEvent
+                    );
+    ASSERT_EFI_ERROR (Status);
+
+    SplitMemoryMapNotify (MemoryMapChangeEvent, NULL);
   }
 }
 
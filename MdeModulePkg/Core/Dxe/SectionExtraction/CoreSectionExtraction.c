@@ -98,6 +98,30 @@ typedef struct {
   VOID                        *Registration;
 } RPN_EVENT_CONTEXT;
 
+//
+// Memory the cache of decompressed sections may hold, counting both the
+// encapsulation sections and their decompressed streams.
+//
+#define CORE_SECTION_CACHE_SIZE       SIZE_4MB
+
+#define CORE_SECTION_CACHE_SIGNATURE  SIGNATURE_32('S','X','C','C')
+#define SECTION_CACHE_ENTRY_FROM_LINK(Node) \
+  CR (Node, CORE_SECTION_CACHE_ENTRY, Link, CORE_SECTION_CACHE_SIGNATURE)
+
+//
+// A decompressed section stream, kept so that the same encapsulation section
+// is not decompressed again when it is found through another stream.  The
+// entry is keyed by the whole encapsulation section, header included.
+//
+typedef struct {
+  UINT32                      Signature;
+  LIST_ENTRY                  Link;
+  UINTN                       SectionSize;
+  UINT8                       *Section;
+  UINTN                       StreamLength;
+  UINT8                       *StreamBuffer;
+} CORE_SECTION_CACHE_ENTRY;
+
 
 /**
   The ExtractSection() function processes the input section and
@@ -197,6 +221,15 @@ CustomGuidedSectionExtract (
 //
 LIST_ENTRY mStreamRoot = INITIALIZE_LIST_HEAD_VARIABLE (mStreamRoot);
 
+//
+// Decompressed sections, most recently used first
+//
+LIST_ENTRY mSectionCacheList = INITIALIZE_LIST_HEAD_VARIABLE (mSectionCacheList);
+UINTN      mSectionCacheSize = 0;
+UINT64     mSectionCacheHitCount = 0;
+UINT64     mSectionCacheMissCount = 0;
+UINT64     mSectionCacheSavedBytes = 0;
+
 EFI_HANDLE mSectionExtractionHandle = NULL;
 
 EFI_GUIDED_SECTION_EXTRACTION_PROTOCOL mCustomGuidedSectionExtractionProtocol = {
@@ -647,6 +680,190 @@ CreateGuidedExtractionRpnEvent (
                                 );
 }
 
+/**
+  Worker function.  Looks for an encapsulation section in the cache of
+  decompressed sections.
+
+  @param  Section                The encapsulation section.
+  @param  SectionSize            The size of the section, header included.
+
+  @return The cache entry of the section, or NULL if it is not cached.
+
+**/
+CORE_SECTION_CACHE_ENTRY *
+FindCachedSection (
+  IN     VOID                                  *Section,
+  IN     UINTN                                 SectionSize
+  )
+{
+  LIST_ENTRY                                   *Link;
+  CORE_SECTION_CACHE_ENTRY                     *Entry;
+
+  for (Link = GetFirstNode (&mSectionCacheList); !IsNull (&mSectionCacheList, Link); Link = GetNextNode (&mSectionCacheList, Link)) {
+    Entry = SECTION_CACHE_ENTRY_FROM_LINK (Link);
+    if ((Entry->SectionSize == SectionSize) && (CompareMem (Entry->Section, Section, SectionSize) == 0)) {
+      //
+      // Move the entry to the front of the list, so the list stays in LRU order
+      //
+      RemoveEntryList (&Entry->Link);
+      InsertHeadList (&mSectionCacheList, &Entry->Link);
+      mSectionCacheHitCount++;
+      mSectionCacheSavedBytes += Entry->StreamLength;
+      return Entry;
+    }
+  }
+
+  mSectionCacheMissCount++;
+  return NULL;
+}
+
+/**
+  Worker function.  Copies a decompressed section from the cache into a
+  caller allocated stream buffer.
+
+  @param  Section                The encapsulation section.
+  @param  SectionSize            The size of the section, header included.
+  @param  StreamBuffer           The buffer to copy the decompressed stream to.
+  @param  StreamLength           The size of StreamBuffer.
+
+  @retval TRUE                   The section was cached, and was copied.
+  @retval FALSE                  The section must be decompressed.
+
+**/
+BOOLEAN
+CopyCachedSection (
+  IN     VOID                                  *Section,
+  IN     UINTN                                 SectionSize,
+  OUT    VOID                                  *StreamBuffer,
+  IN     UINTN                                 StreamLength
+  )
+{
+  CORE_SECTION_CACHE_ENTRY                     *Entry;
+  EFI_TPL                                      OldTpl;
+  BOOLEAN                                      Found;
+
+  OldTpl = CoreRaiseTpl (TPL_NOTIFY);
+  Entry = FindCachedSection (Section, SectionSize);
+  Found = (BOOLEAN) ((Entry != NULL) && (Entry->StreamLength == StreamLength));
+  if (Found) {
+    CopyMem (StreamBuffer, Entry->StreamBuffer, StreamLength);
+  }
+  CoreRestoreTpl (OldTpl);
+
+  return Found;
+}
+
+/**
+  Worker function.  Returns a copy of a decompressed section from the cache.
+
+  @param  Section                The encapsulation section.
+  @param  SectionSize            The size of the section, header included.
+  @param  StreamBuffer           Returns the pool allocated copy of the
+                                 decompressed stream.
+  @param  StreamLength           Returns the size of the decompressed stream.
+
+  @retval TRUE                   The section was cached, and was copied.
+  @retval FALSE                  The section must be decompressed.
+
+**/
+BOOLEAN
+AllocateCopyCachedSection (
+  IN     VOID                                  *Section,
+  IN     UINTN                                 SectionSize,
+  OUT    VOID                                  **StreamBuffer,
+  OUT    UINTN                                 *StreamLength
+  )
+{
+  CORE_SECTION_CACHE_ENTRY                     *Entry;
+  EFI_TPL                                      OldTpl;
+  BOOLEAN                                      Found;
+
+  OldTpl = CoreRaiseTpl (TPL_NOTIFY);
+  Entry = FindCachedSection (Section, SectionSize);
+  Found = FALSE;
+  if (Entry != NULL) {
+    *StreamBuffer = AllocateCopyPool (Entry->StreamLength, Entry->StreamBuffer);
+    if (*StreamBuffer != NULL) {
+      *StreamLength = Entry->StreamLength;
+      Found = TRUE;
+    }
+  }
+  CoreRestoreTpl (OldTpl);
+
+  return Found;
+}
+
+/**
+  Worker function.  Adds a decompressed section to the cache, evicting the
+  least recently used sections to keep the cache within
+  CORE_SECTION_CACHE_SIZE.  Nothing is cached if memory is short.
+
+  @param  Section                The encapsulation section.
+  @param  SectionSize            The size of the section, header included.
+  @param  StreamBuffer           The decompressed stream.
+  @param  StreamLength           The size of the decompressed stream.
+
+**/
+VOID
+CacheSection (
+  IN     VOID                                  *Section,
+  IN     UINTN                                 SectionSize,
+  IN     VOID                                  *StreamBuffer,
+  IN     UINTN                                 StreamLength
+  )
+{
+  CORE_SECTION_CACHE_ENTRY                     *Entry;
+  EFI_TPL                                      OldTpl;
+
+  if ((StreamLength == 0) || (SectionSize + StreamLength > CORE_SECTION_CACHE_SIZE / 4)) {
+    return;
+  }
+
+  Entry = AllocatePool (sizeof (CORE_SECTION_CACHE_ENTRY) + SectionSize + StreamLength);
+  if (Entry == NULL) {
+    return;
+  }
+  Entry->Signature    = CORE_SECTION_CACHE_SIGNATURE;
+  Entry->SectionSize  = SectionSize;
+  Entry->Section      = (UINT8 *) (Entry + 1);
+  Entry->StreamLength = StreamLength;
+  Entry->StreamBuffer = Entry->Section + SectionSize;
+  CopyMem (Entry->Section, Section, SectionSize);
+  CopyMem (Entry->StreamBuffer, StreamBuffer, StreamLength);
+
+  OldTpl = CoreRaiseTpl (TPL_NOTIFY);
+  InsertHeadList (&mSectionCacheList, &Entry->Link);
+  mSectionCacheSize += SectionSize + StreamLength;
+  while (mSectionCacheSize > CORE_SECTION_CACHE_SIZE) {
+    Entry = SECTION_CACHE_ENTRY_FROM_LINK (GetPreviousNode (&mSectionCacheList, &mSectionCacheList));
+    RemoveEntryList (&Entry->Link);
+    mSectionCacheSize -= Entry->SectionSize + Entry->StreamLength;
+    CoreFreePool (Entry);
+  }
+  CoreRestoreTpl (OldTpl);
+}
+
+/**
+  Displays how many encapsulation sections were found in the cache of
+  decompressed sections, how many were not, and how many decompressed bytes
+  the cache provided.  Only used in Debug Builds.
+
+**/
+VOID
+CoreDisplaySectionCacheStatistics (
+  VOID
+  )
+{
+  DEBUG ((
+    DEBUG_INFO,
+    "Section cache: %ld hits, %ld misses, %ld bytes not decompressed again, %d bytes cached\n",
+    mSectionCacheHitCount,
+    mSectionCacheMissCount,
+    mSectionCacheSavedBytes,
+    mSectionCacheSize
+    ));
+}
+
 /**
   Worker function.  Constructor for new child nodes.
 
@@ -762,6 +979,12 @@ CreateChildNode (
           // stream is not actually compressed, just encapsulated.  So just copy it.
           //
           CopyMem (NewStreamBuffer, CompressionSource, NewStreamBufferSize);
+        } else if ((CompressionType == EFI_STANDARD_COMPRESSION) &&
+                   CopyCachedSection (SectionHeader, Node->Size, NewStreamBuffer, NewStreamBufferSize)) {
+          //
+          // The same section has been decompressed before, so it was copied
+          // from the cache.
+          //
         } else if (CompressionType == EFI_STANDARD_COMPRESSION) {
           //
           // Only support the EFI_SATNDARD_COMPRESSION algorithm.
@@ -812,6 +1035,8 @@ CreateChildNode (
             CoreFreePool (NewStreamBuffer);
             return Status;
           }
+
+          CacheSection (SectionHeader, Node->Size, NewStreamBuffer, NewStreamBufferSize);
         }
       } else {
         NewStreamBuffer = NULL;
@@ -843,19 +1068,31 @@ CreateChildNode (
       }
       if (VerifyGuidedSectionGuid (Node->EncapsulationGuid, &GuidedExtraction)) {
         //
-        // NewStreamBuffer is always allocated by ExtractSection... No caller
-        // allocation here.
+        // A section that contributes no authentication status only has to be
+        // extracted once. Sections that do are extracted every time, so that
+        // they are authenticated every time.
         //
-        Status = GuidedExtraction->ExtractSection (
-                                     GuidedExtraction,
-                                     GuidedHeader,
-                                     &NewStreamBuffer,
-                                     &NewStreamBufferSize,
-                                     &AuthenticationStatus
-                                     );
-        if (EFI_ERROR (Status)) {
-          CoreFreePool (*ChildNode);
-          return EFI_PROTOCOL_ERROR;
+        if (((GuidedSectionAttributes & EFI_GUIDED_SECTION_AUTH_STATUS_VALID) != 0) ||
+            !AllocateCopyCachedSection (GuidedHeader, Node->Size, &NewStreamBuffer, &NewStreamBufferSize)) {
+          //
+          // NewStreamBuffer is always allocated by ExtractSection... No caller
+          // allocation here.
+          //
+          Status = GuidedExtraction->ExtractSection (
+                                       GuidedExtraction,
+                                       GuidedHeader,
+                                       &NewStreamBuffer,
+                                       &NewStreamBufferSize,
+                                       &AuthenticationStatus
+                                       );
+          if (EFI_ERROR (Status)) {
+            CoreFreePool (*ChildNode);
+            return EFI_PROTOCOL_ERROR;
+          }
+
+          if ((GuidedSectionAttributes & EFI_GUIDED_SECTION_AUTH_STATUS_VALID) == 0) {
+            CacheSection (GuidedHeader, Node->Size, NewStreamBuffer, NewStreamBufferSize);
+          }
         }
 
         //
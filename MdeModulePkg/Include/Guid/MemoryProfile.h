@@ -111,6 +111,17 @@ typedef struct {
   //MEMORY_PROFILE_DESCRIPTOR     MemoryDescriptor[MemoryRangeCount];
 } MEMORY_PROFILE_MEMORY_RANGE;
 
+#define MEMORY_PROFILE_POOL_CACHE_SIGNATURE SIGNATURE_32 ('M','P','P','C')
+#define MEMORY_PROFILE_POOL_CACHE_REVISION 0x0001
+
+typedef struct {
+  MEMORY_PROFILE_COMMON_HEADER  Header;
+  UINT64                        HitCount;
+  UINT64                        MissCount;
+  UINT64                        WastedBytes;
+  UINT64                        CachedBytes;
+} MEMORY_PROFILE_POOL_CACHE;
+
 //
 // UEFI memory profile layout:
 // +--------------------------------+
@@ -128,6 +139,8 @@ typedef struct {
 // +--------------------------------+
 // | ALLOC_INFO(n, mn)              |
 // +--------------------------------+
+// | POOL_CACHE                     |
+// +--------------------------------+
 //
 
 typedef struct _EDKII_MEMORY_PROFILE_PROTOCOL EDKII_MEMORY_PROFILE_PROTOCOL;
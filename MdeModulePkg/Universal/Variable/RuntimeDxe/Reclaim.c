@@ -97,6 +97,8 @@ GetLbaAndOffsetByAddress (
   This function writes a buffer to variable storage space into a firmware
   volume block device. The destination is specified by parameter
   VariableBase. Fault Tolerant Write protocol is used for writing.
+  Only the range that differs from the variable storage space is written,
+  so that the blocks left as they are do not have to be erased.
 
   @param  VariableBase   Base address of variable to write
   @param  VariableBuffer Point to the variable data buffer.
@@ -111,6 +113,34 @@ FtwVariableSpace (
   IN EFI_PHYSICAL_ADDRESS   VariableBase,
   IN VARIABLE_STORE_HEADER  *VariableBuffer
   )
+{
+  return FtwVariableSpaceRange (VariableBase, VariableBuffer, 0, VariableBuffer->Size);
+}
+
+/**
+  Writes a range of a buffer to variable storage space, in the working block.
+
+  Same as FtwVariableSpace(), for a caller that knows the buffer only differs
+  from the variable storage space within the range, so that the rest of the
+  space does not have to be compared.
+
+  @param  VariableBase   Base address of variable to write
+  @param  VariableBuffer Point to the variable data buffer.
+  @param  Offset         Offset of the range in the variable data buffer.
+  @param  Length         Length of the range.
+
+  @retval EFI_SUCCESS    The function completed successfully.
+  @retval EFI_NOT_FOUND  Fail to locate Fault Tolerant Write protocol.
+  @retval EFI_ABORTED    The function could not complete successfully.
+
+**/
+EFI_STATUS
+FtwVariableSpaceRange (
+  IN EFI_PHYSICAL_ADDRESS   VariableBase,
+  IN VARIABLE_STORE_HEADER  *VariableBuffer,
+  IN UINTN                  Offset,
+  IN UINTN                  Length
+  )
 {
   EFI_STATUS                         Status;
   EFI_HANDLE                         FvbHandle;
@@ -118,6 +148,10 @@ FtwVariableSpace (
   UINTN                              VarOffset;
   UINTN                              FtwBufferSize;
   EFI_FAULT_TOLERANT_WRITE_PROTOCOL  *FtwProtocol;
+  UINT8                              *Current;
+  UINT8                              *Buffer;
+  UINTN                              Start;
+  UINTN                              End;
 
   //
   // Locate fault tolerant write protocol.
@@ -133,17 +167,33 @@ FtwVariableSpace (
   if (EFI_ERROR (Status)) {
     return Status;
   }
+
+  FtwBufferSize = ((VARIABLE_STORE_HEADER *) ((UINTN) VariableBase))->Size;
+  ASSERT (FtwBufferSize == VariableBuffer->Size);
+  ASSERT (Offset + Length <= FtwBufferSize);
+
+  //
+  // Skip the leading and trailing bytes that are already there, the variables
+  // at the start of the store and the free space at its end usually are.
+  //
+  Current = (UINT8 *) (UINTN) VariableBase;
+  Buffer  = (UINT8 *) VariableBuffer;
+  for (Start = Offset; (Start < Offset + Length) && (Current[Start] == Buffer[Start]); Start++);
+  if (Start == Offset + Length) {
+    return EFI_SUCCESS;
+  }
+  for (End = Offset + Length; Current[End - 1] == Buffer[End - 1]; End--);
+
+  DEBUG ((EFI_D_INFO, "Variable FTW write 0x%x bytes at offset 0x%x of 0x%x\n", End - Start, Start, FtwBufferSize));
+
   //
   // Get LBA and Offset by address.
   //
-  Status = GetLbaAndOffsetByAddress (VariableBase, &VarLba, &VarOffset);
+  Status = GetLbaAndOffsetByAddress (VariableBase + Start, &VarLba, &VarOffset);
   if (EFI_ERROR (Status)) {
     return EFI_ABORTED;
   }
 
-  FtwBufferSize = ((VARIABLE_STORE_HEADER *) ((UINTN) VariableBase))->Size;
-  ASSERT (FtwBufferSize == VariableBuffer->Size);
-
   //
   // FTW write record.
   //
@@ -151,10 +201,10 @@ FtwVariableSpace (
                           FtwProtocol,
                           VarLba,         // LBA
                           VarOffset,      // Offset
-                          FtwBufferSize,  // NumBytes
+                          End - Start,    // NumBytes
                           NULL,           // PrivateData NULL
                           FvbHandle,      // Fvb Handle
-                          (VOID *) VariableBuffer // write buffer
+                          Buffer + Start  // write buffer
                           );
 
   return Status;
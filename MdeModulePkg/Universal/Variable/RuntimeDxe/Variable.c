@@ -978,6 +978,248 @@ InitializeVariableQuota (
   CalculateCommonUserVariableTotalSize ();
 }
 
+/**
+  Drop all entries of a variable store hash index.
+
+  The index is built again on the next lookup. This must be called whenever
+  variables are moved inside the store, e.g. by Reclaim().
+
+  @param[in, out] Index         Pointer to the index, may be NULL.
+
+**/
+VOID
+ResetVariableIndex (
+  IN OUT VARIABLE_INDEX         *Index
+  )
+{
+  if (Index == NULL) {
+    return;
+  }
+
+  Index->IndexedOffset = 0;
+  Index->EntryCount    = 0;
+  ZeroMem (VARIABLE_INDEX_BUCKETS (Index), Index->BucketCount * sizeof (UINT32));
+}
+
+/**
+  Create an empty hash index for a variable store.
+
+  @param[in] StoreSize          Size of the variable store in bytes.
+
+  @return Pointer to the index, or NULL if it could not be allocated.
+
+**/
+VARIABLE_INDEX *
+CreateVariableIndex (
+  IN UINTN                      StoreSize
+  )
+{
+  VARIABLE_INDEX                *Index;
+  UINT32                        MaxEntryCount;
+  UINT32                        BucketCount;
+
+  MaxEntryCount = (UINT32) (StoreSize / VARIABLE_INDEX_BYTES_PER_ENTRY);
+  BucketCount   = GetPowerOfTwo32 (MaxEntryCount / 2);
+  if (BucketCount == 0) {
+    return NULL;
+  }
+
+  Index = AllocateRuntimePool (
+            sizeof (VARIABLE_INDEX) +
+            BucketCount * sizeof (UINT32) +
+            MaxEntryCount * sizeof (VARIABLE_INDEX_ENTRY)
+            );
+  if (Index == NULL) {
+    return NULL;
+  }
+
+  Index->BucketCount   = BucketCount;
+  Index->MaxEntryCount = MaxEntryCount;
+  ResetVariableIndex (Index);
+  return Index;
+}
+
+/**
+  Compute the hash index key of a variable.
+
+  @param[in] VariableName       Name of the variable.
+  @param[in] NameSize           Maximum size of the name in bytes.
+  @param[in] VendorGuid         Vendor GUID of the variable.
+
+  @return Hash of the name up to its terminator and of the vendor GUID.
+
+**/
+UINT32
+GetVariableIndexHash (
+  IN CHAR16                     *VariableName,
+  IN UINTN                      NameSize,
+  IN EFI_GUID                   *VendorGuid
+  )
+{
+  UINT32                        Hash;
+  UINTN                         Index;
+
+  Hash = ReadUnaligned32 ((UINT32 *) VendorGuid);
+  for (Index = 0; Index < NameSize / sizeof (CHAR16) && VariableName[Index] != 0; Index++) {
+    Hash = Hash * 31 + VariableName[Index];
+  }
+  return Hash;
+}
+
+/**
+  Add the variables appended to a variable store since the last call to its hash index.
+
+  Only variables that end below LastVariableOffset are indexed, so a variable
+  still being written is picked up by a later call.
+
+  @param[in, out] Index               Pointer to the index.
+  @param[in]      VariableStoreHeader Pointer to the variable store the index covers.
+  @param[in]      LastVariableOffset  Offset of the free space of the variable store.
+
+**/
+VOID
+UpdateVariableIndex (
+  IN OUT VARIABLE_INDEX         *Index,
+  IN     VARIABLE_STORE_HEADER  *VariableStoreHeader,
+  IN     UINTN                  LastVariableOffset
+  )
+{
+  VARIABLE_HEADER               *Variable;
+  VARIABLE_HEADER               *NextVariable;
+  UINT32                        *Bucket;
+  VARIABLE_INDEX_ENTRY          *Entry;
+  UINT32                        Hash;
+
+  if (Index->IndexedOffset == 0) {
+    Variable = GetStartPointer (VariableStoreHeader);
+  } else {
+    Variable = (VARIABLE_HEADER *) ((UINTN) VariableStoreHeader + Index->IndexedOffset);
+  }
+
+  Bucket = VARIABLE_INDEX_BUCKETS (Index);
+  Entry  = VARIABLE_INDEX_ENTRIES (Index);
+  while ((Index->EntryCount < Index->MaxEntryCount) &&
+         IsValidVariableHeader (Variable, GetEndPointer (VariableStoreHeader))) {
+    NextVariable = GetNextVariablePtr (Variable);
+    if ((UINTN) NextVariable - (UINTN) VariableStoreHeader > LastVariableOffset) {
+      break;
+    }
+
+    Hash = GetVariableIndexHash (
+             GetVariableNamePtr (Variable),
+             NameSizeOfVariable (Variable),
+             GetVendorGuidPtr (Variable)
+             ) & (Index->BucketCount - 1);
+    Entry[Index->EntryCount].Offset = (UINT32) ((UINTN) Variable - (UINTN) VariableStoreHeader);
+    Entry[Index->EntryCount].Next   = Bucket[Hash];
+    Index->EntryCount++;
+    Bucket[Hash] = Index->EntryCount;
+
+    Variable = NextVariable;
+  }
+
+  Index->IndexedOffset = (UINTN) Variable - (UINTN) VariableStoreHeader;
+}
+
+/**
+  Find the variable in the hash index of the variable store PtrTrack covers.
+
+  Variables the index does not cover yet are left to the caller, which has
+  to walk the store from PtrTrack->CurrPtr on if EFI_NOT_FOUND is returned.
+
+  @param[in]       VariableName        Name of the variable to be found, not empty.
+  @param[in]       VendorGuid          Vendor GUID to be found.
+  @param[in]       IgnoreRtCheck       Ignore EFI_VARIABLE_RUNTIME_ACCESS attribute
+                                       check at runtime when searching variable.
+  @param[in, out]  PtrTrack            Variable Track Pointer structure that contains Variable Information.
+  @param[out]      InDeletedVariable   The last IN_DELETED_TRANSITION variable found
+                                       in the part of the store covered by the index.
+
+  @retval          EFI_SUCCESS         An ADDED variable was found in the index.
+  @retval          EFI_NOT_FOUND       The store has to be walked from PtrTrack->CurrPtr on.
+**/
+EFI_STATUS
+FindVariableInIndex (
+  IN     CHAR16                  *VariableName,
+  IN     EFI_GUID                *VendorGuid,
+  IN     BOOLEAN                 IgnoreRtCheck,
+  IN OUT VARIABLE_POINTER_TRACK  *PtrTrack,
+  OUT    VARIABLE_HEADER         **InDeletedVariable
+  )
+{
+  VARIABLE_STORE_HEADER          *VariableStoreHeader;
+  VARIABLE_INDEX                 *Index;
+  VARIABLE_INDEX_ENTRY           *Entry;
+  VARIABLE_HEADER                *Variable;
+  VARIABLE_HEADER                *AddedVariable;
+  UINTN                          LastVariableOffset;
+  UINT32                         EntryNumber;
+
+  *InDeletedVariable = NULL;
+  PtrTrack->CurrPtr  = PtrTrack->StartPtr;
+
+  VariableStoreHeader = (VARIABLE_STORE_HEADER *) (UINTN) mVariableModuleGlobal->VariableGlobal.VolatileVariableBase;
+  if (PtrTrack->StartPtr == GetStartPointer (VariableStoreHeader)) {
+    Index              = mVariableModuleGlobal->VolatileIndex;
+    LastVariableOffset = mVariableModuleGlobal->VolatileLastVariableOffset;
+  } else if ((mNvVariableCache != NULL) && (PtrTrack->StartPtr == GetStartPointer (mNvVariableCache))) {
+    VariableStoreHeader = mNvVariableCache;
+    Index               = mVariableModuleGlobal->NvIndex;
+    LastVariableOffset  = mVariableModuleGlobal->NonVolatileLastVariableOffset;
+  } else {
+    return EFI_NOT_FOUND;
+  }
+
+  if (Index == NULL) {
+    return EFI_NOT_FOUND;
+  }
+
+  UpdateVariableIndex (Index, VariableStoreHeader, LastVariableOffset);
+
+  //
+  // The chain of a bucket runs from the end of the store towards its start.
+  // Keep the ADDED variable nearest to the start and the IN_DELETED_TRANSITION
+  // one right before it, which is what walking the store would return.
+  //
+  AddedVariable = NULL;
+  Entry         = VARIABLE_INDEX_ENTRIES (Index);
+  EntryNumber   = VARIABLE_INDEX_BUCKETS (Index)[GetVariableIndexHash (VariableName, MAX_UINTN, VendorGuid) & (Index->BucketCount - 1)];
+  for (; EntryNumber != 0; EntryNumber = Entry[EntryNumber - 1].Next) {
+    Variable = (VARIABLE_HEADER *) ((UINTN) VariableStoreHeader + Entry[EntryNumber - 1].Offset);
+    if (Variable->State != VAR_ADDED &&
+        Variable->State != (VAR_IN_DELETED_TRANSITION & VAR_ADDED)
+       ) {
+      continue;
+    }
+    if (!IgnoreRtCheck && AtRuntime () && ((Variable->Attributes & EFI_VARIABLE_RUNTIME_ACCESS) == 0)) {
+      continue;
+    }
+    if (!CompareGuid (VendorGuid, GetVendorGuidPtr (Variable))) {
+      continue;
+    }
+    ASSERT (NameSizeOfVariable (Variable) != 0);
+    if (CompareMem (VariableName, GetVariableNamePtr (Variable), NameSizeOfVariable (Variable)) != 0) {
+      continue;
+    }
+
+    if (Variable->State == VAR_ADDED) {
+      AddedVariable      = Variable;
+      *InDeletedVariable = NULL;
+    } else if (*InDeletedVariable == NULL) {
+      *InDeletedVariable = Variable;
+    }
+  }
+
+  if (AddedVariable != NULL) {
+    PtrTrack->CurrPtr                = AddedVariable;
+    PtrTrack->InDeletedTransitionPtr = *InDeletedVariable;
+    return EFI_SUCCESS;
+  }
+
+  PtrTrack->CurrPtr = (VARIABLE_HEADER *) ((UINTN) VariableStoreHeader + Index->IndexedOffset);
+  return EFI_NOT_FOUND;
+}
+
 /**
 
   Variable store garbage collection and reclaim operation.
@@ -1083,6 +1325,14 @@ Reclaim (
     ValidBuffer = (UINT8 *) mNvVariableCache;
   }
 
+  //
+  // The volatile store may be reclaimed at OS runtime, when the performance
+  // library can no longer be used.
+  //
+  if (!AtRuntime ()) {
+    PERF_START (NULL, "Reclaim", "Variable", 0);
+  }
+
   SetMem (ValidBuffer, MaximumBufferSize, 0xff);
 
   //
@@ -1237,7 +1487,7 @@ Reclaim (
         VariableSize = (UINTN) NextVariable - (UINTN) Variable;
         if ((Variable->Attributes & EFI_VARIABLE_HARDWARE_ERROR_RECORD) == EFI_VARIABLE_HARDWARE_ERROR_RECORD) {
           mVariableModuleGlobal->HwErrVariableTotalSize += VariableSize;
-        } else if ((Variable->Attributes & EFI_VARIABLE_HARDWARE_ERROR_RECORD) != EFI_VARIABLE_HARDWARE_ERROR_RECORD) {
+        } else if ((Variable->Attributes & EFI_VARIABLE_NON_VOLATILE) != 0) {
           mVariableModuleGlobal->CommonVariableTotalSize += VariableSize;
           if (IsUserVariable (Variable)) {
             mVariableModuleGlobal->CommonUserVariableTotalSize += VariableSize;
@@ -1253,11 +1503,19 @@ Reclaim (
 Done:
   if (IsVolatile) {
     FreePool (ValidBuffer);
+    ResetVariableIndex (mVariableModuleGlobal->VolatileIndex);
+    mVariableModuleGlobal->ReclaimCount++;
   } else {
     //
     // For NV variable reclaim, we use mNvVariableCache as the buffer, so copy the data back.
     //
     CopyMem (mNvVariableCache, (UINT8 *)(UINTN)VariableBase, VariableStoreHeader->Size);
+    ResetVariableIndex (mVariableModuleGlobal->NvIndex);
+    mVariableModuleGlobal->ReclaimCount++;
+  }
+
+  if (!AtRuntime ()) {
+    PERF_END (NULL, "Reclaim", "Variable", 0);
   }
 
   return Status;
@@ -1292,9 +1550,18 @@ FindVariableEx (
   // Find the variable by walk through HOB, volatile and non-volatile variable store.
   //
   InDeletedVariable  = NULL;
+  PtrTrack->CurrPtr  = PtrTrack->StartPtr;
+
+  if (VariableName[0] != 0) {
+    //
+    // Only the variables not covered by the hash index need to be walked.
+    //
+    if (!EFI_ERROR (FindVariableInIndex (VariableName, VendorGuid, IgnoreRtCheck, PtrTrack, &InDeletedVariable))) {
+      return EFI_SUCCESS;
+    }
+  }
 
-  for ( PtrTrack->CurrPtr = PtrTrack->StartPtr
-      ; IsValidVariableHeader (PtrTrack->CurrPtr, PtrTrack->EndPtr)
+  for ( ; IsValidVariableHeader (PtrTrack->CurrPtr, PtrTrack->EndPtr)
       ; PtrTrack->CurrPtr = GetNextVariablePtr (PtrTrack->CurrPtr)
       ) {
     if (PtrTrack->CurrPtr->State == VAR_ADDED ||
@@ -2889,6 +3156,100 @@ Done:
   return Status;
 }
 
+/**
+  Find the GetNextVariableName() cursor left at the variable a caller got last.
+
+  The cursor is only used while the variable is still ADDED and no reclaim has
+  moved the variables since, the variable driver keeping a single ADDED copy of
+  a variable. FindVariable() would then return the very same variable.
+
+  @param[in]  VariableName        Name of the variable returned last.
+  @param[in]  VendorGuid          Vendor GUID of the variable returned last.
+  @param[in]  VariableStoreHeader Variable store headers indexed by VARIABLE_STORE_TYPE.
+  @param[out] PtrTrack            The store and position of the variable.
+
+  @return Pointer to the cursor, or NULL if the variable has to be looked up.
+
+**/
+VARIABLE_NEXT_CURSOR *
+FindNextVariableCursor (
+  IN  CHAR16                  *VariableName,
+  IN  EFI_GUID                *VendorGuid,
+  IN  VARIABLE_STORE_HEADER   **VariableStoreHeader,
+  OUT VARIABLE_POINTER_TRACK  *PtrTrack
+  )
+{
+  VARIABLE_NEXT_CURSOR        *Cursor;
+  VARIABLE_HEADER             *Variable;
+  UINTN                       Index;
+
+  for (Index = 0; Index < VARIABLE_NEXT_CURSOR_COUNT; Index++) {
+    Cursor = &mVariableModuleGlobal->NextCursor[Index];
+    if ((Cursor->Offset == 0) ||
+        (Cursor->ReclaimCount != mVariableModuleGlobal->ReclaimCount) ||
+        (VariableStoreHeader[Cursor->Type] == NULL)) {
+      continue;
+    }
+
+    Variable = (VARIABLE_HEADER *) ((UINTN) VariableStoreHeader[Cursor->Type] + Cursor->Offset);
+    if (!IsValidVariableHeader (Variable, GetEndPointer (VariableStoreHeader[Cursor->Type])) ||
+        (Variable->State != VAR_ADDED) ||
+        (AtRuntime () && ((Variable->Attributes & EFI_VARIABLE_RUNTIME_ACCESS) == 0)) ||
+        !CompareGuid (VendorGuid, GetVendorGuidPtr (Variable)) ||
+        (CompareMem (VariableName, GetVariableNamePtr (Variable), NameSizeOfVariable (Variable)) != 0)) {
+      continue;
+    }
+
+    PtrTrack->StartPtr = GetStartPointer (VariableStoreHeader[Cursor->Type]);
+    PtrTrack->EndPtr   = GetEndPointer   (VariableStoreHeader[Cursor->Type]);
+    PtrTrack->CurrPtr  = Variable;
+    return Cursor;
+  }
+
+  return NULL;
+}
+
+/**
+  Leave a GetNextVariableName() cursor at the variable returned to a caller.
+
+  @param[in] Cursor               The cursor the caller continued from, or NULL
+                                  to take the least recently set one.
+  @param[in] VariableStoreHeader  Variable store headers indexed by VARIABLE_STORE_TYPE.
+  @param[in] PtrTrack             The store and position of the returned variable.
+
+**/
+VOID
+SetNextVariableCursor (
+  IN VARIABLE_NEXT_CURSOR     *Cursor OPTIONAL,
+  IN VARIABLE_STORE_HEADER    **VariableStoreHeader,
+  IN VARIABLE_POINTER_TRACK   *PtrTrack
+  )
+{
+  VARIABLE_STORE_TYPE         Type;
+
+  if (Cursor == NULL) {
+    Cursor = &mVariableModuleGlobal->NextCursor[mVariableModuleGlobal->NextCursorIndex];
+    mVariableModuleGlobal->NextCursorIndex = (mVariableModuleGlobal->NextCursorIndex + 1) % VARIABLE_NEXT_CURSOR_COUNT;
+  }
+
+  Cursor->Offset = 0;
+  if (PtrTrack->CurrPtr->State != VAR_ADDED) {
+    //
+    // An IN_DELETED_TRANSITION variable may have several copies, look it up next time.
+    //
+    return;
+  }
+
+  for (Type = (VARIABLE_STORE_TYPE) 0; Type < VariableStoreTypeMax; Type++) {
+    if ((VariableStoreHeader[Type] != NULL) && (PtrTrack->StartPtr == GetStartPointer (VariableStoreHeader[Type]))) {
+      Cursor->Type         = Type;
+      Cursor->Offset       = (UINTN) PtrTrack->CurrPtr - (UINTN) VariableStoreHeader[Type];
+      Cursor->ReclaimCount = mVariableModuleGlobal->ReclaimCount;
+      return;
+    }
+  }
+}
+
 /**
   This code Finds the Next available variable.
 
@@ -2917,18 +3278,7 @@ VariableServiceGetNextVariableInternal (
   VARIABLE_POINTER_TRACK  VariablePtrTrack;
   EFI_STATUS              Status;
   VARIABLE_STORE_HEADER   *VariableStoreHeader[VariableStoreTypeMax];
-
-  Status = FindVariable (VariableName, VendorGuid, &Variable, &mVariableModuleGlobal->VariableGlobal, FALSE);
-  if (Variable.CurrPtr == NULL || EFI_ERROR (Status)) {
-    goto Done;
-  }
-
-  if (VariableName[0] != 0) {
-    //
-    // If variable name is not NULL, get next variable.
-    //
-    Variable.CurrPtr = GetNextVariablePtr (Variable.CurrPtr);
-  }
+  VARIABLE_NEXT_CURSOR    *Cursor;
 
   //
   // 0: Volatile, 1: HOB, 2: Non-Volatile.
@@ -2939,6 +3289,29 @@ VariableServiceGetNextVariableInternal (
   VariableStoreHeader[VariableStoreTypeHob]      = (VARIABLE_STORE_HEADER *) (UINTN) mVariableModuleGlobal->VariableGlobal.HobVariableBase;
   VariableStoreHeader[VariableStoreTypeNv]       = mNvVariableCache;
 
+  //
+  // Continue an enumeration from its cursor if possible, so that enumerating
+  // all variables does not look up every variable again.
+  //
+  Cursor = NULL;
+  if (VariableName[0] != 0) {
+    Cursor = FindNextVariableCursor (VariableName, VendorGuid, VariableStoreHeader, &Variable);
+  }
+
+  if (Cursor == NULL) {
+    Status = FindVariable (VariableName, VendorGuid, &Variable, &mVariableModuleGlobal->VariableGlobal, FALSE);
+    if (Variable.CurrPtr == NULL || EFI_ERROR (Status)) {
+      goto Done;
+    }
+  }
+
+  if (VariableName[0] != 0) {
+    //
+    // If variable name is not NULL, get next variable.
+    //
+    Variable.CurrPtr = GetNextVariablePtr (Variable.CurrPtr);
+  }
+
   while (TRUE) {
     //
     // Switch from Volatile to HOB, to Non-Volatile.
@@ -3020,6 +3393,7 @@ VariableServiceGetNextVariableInternal (
           }
         }
 
+        SetNextVariableCursor (Cursor, VariableStoreHeader, &Variable);
         *VariablePtr = Variable.CurrPtr;
         Status = EFI_SUCCESS;
         goto Done;
@@ -3308,6 +3682,14 @@ VariableServiceSetVariable (
     Status = UpdateVariable (VariableName, VendorGuid, Data, DataSize, Attributes, 0, 0, &Variable, NULL);
   }
 
+  if (!EFI_ERROR (Status) &&
+      (((Attributes & EFI_VARIABLE_NON_VOLATILE) != 0) || ((Variable.CurrPtr != NULL) && !Variable.Volatile))) {
+    //
+    // Spread the reclaim of the deleted variables over the NV writes at boot time.
+    //
+    ReclaimStep ();
+  }
+
 Done:
   InterlockedDecrement (&mVariableModuleGlobal->VariableGlobal.ReentrantState);
   ReleaseLockOnlyAtBootTime (&mVariableModuleGlobal->VariableGlobal.VariableServicesLock);
@@ -3577,7 +3959,487 @@ VariableServiceQueryVariableInfo (
 }
 
 /**
-  This function reclaims variable storage if free size is below the threshold.
+  Check if a reclaim of the NV variable store would drop the variable.
+
+  Same as Reclaim(), a variable is dropped if it is neither ADDED nor
+  IN_DELETED_TRANSITION, or if it is IN_DELETED_TRANSITION and an ADDED
+  variable with the same name and GUID is in the store.
+
+  @param[in] Variable           Pointer to the variable in mNvVariableCache.
+
+  @retval TRUE                  The variable would be dropped.
+  @retval FALSE                 The variable would be kept.
+
+**/
+BOOLEAN
+IsReclaimableVariable (
+  IN VARIABLE_HEADER            *Variable
+  )
+{
+  EFI_STATUS                    Status;
+  VARIABLE_POINTER_TRACK        PtrTrack;
+
+  if (Variable->State == VAR_ADDED) {
+    return FALSE;
+  }
+
+  if (Variable->State != (VAR_IN_DELETED_TRANSITION & VAR_ADDED)) {
+    return TRUE;
+  }
+
+  PtrTrack.StartPtr = GetStartPointer (mNvVariableCache);
+  PtrTrack.EndPtr   = GetEndPointer (mNvVariableCache);
+  PtrTrack.Volatile = FALSE;
+  Status = FindVariableEx (GetVariableNamePtr (Variable), GetVendorGuidPtr (Variable), TRUE, &PtrTrack);
+
+  return (BOOLEAN) (!EFI_ERROR (Status) && (PtrTrack.CurrPtr->State == VAR_ADDED));
+}
+
+/**
+  Get the size of the non-volatile variables that a reclaim would drop.
+
+  @return Size in bytes of the variables in the NV variable store that
+          IsReclaimableVariable() reports.
+
+**/
+UINTN
+GetReclaimableVariableSize (
+  VOID
+  )
+{
+  VARIABLE_HEADER                *Variable;
+  VARIABLE_HEADER                *NextVariable;
+  UINTN                          ReclaimableSize;
+
+  ReclaimableSize = 0;
+  Variable = GetStartPointer (mNvVariableCache);
+  while (IsValidVariableHeader (Variable, GetEndPointer (mNvVariableCache))) {
+    NextVariable = GetNextVariablePtr (Variable);
+    if (IsReclaimableVariable (Variable)) {
+      ReclaimableSize += (UINTN) NextVariable - (UINTN) Variable;
+    }
+
+    Variable = NextVariable;
+  }
+
+  return ReclaimableSize;
+}
+
+/**
+  Turn the space at a variable into a single deleted variable.
+
+  Only the variable header and name are written, the old content of the rest
+  of the space is left as data of the deleted variable.
+
+  @param[in] Variable           Pointer to the space in mNvVariableCache.
+  @param[in] Size               Size of the space, at least the header size
+                                plus an aligned CHAR16 name.
+
+**/
+VOID
+SetDeletedVariable (
+  IN VARIABLE_HEADER            *Variable,
+  IN UINTN                      Size
+  )
+{
+  ASSERT (Size >= GetVariableHeaderSize () + sizeof (CHAR16) + GET_PAD_SIZE (sizeof (CHAR16)));
+
+  SetMem (Variable, GetVariableHeaderSize (), 0);
+  Variable->StartId = VARIABLE_DATA;
+  Variable->State   = VAR_ADDED & VAR_DELETED;
+  SetNameSizeOfVariable (Variable, sizeof (CHAR16));
+  SetDataSizeOfVariable (Variable, Size - GetVariableHeaderSize () - sizeof (CHAR16) - GET_PAD_SIZE (sizeof (CHAR16)));
+  *GetVariableNamePtr (Variable) = L'\0';
+  ASSERT ((UINTN) GetNextVariablePtr (Variable) == (UINTN) Variable + Size);
+}
+
+/**
+  Add the size of a variable to the total size of the non-volatile variables
+  of its kind.
+
+  The deleted variables that ReclaimStep() writes to gather dropped space have
+  no attributes and are not counted, so that the totals are those Reclaim()
+  would compute once the store has been reclaimed.
+
+  @param[in]      Variable                     Pointer to the variable.
+  @param[in, out] HwErrVariableTotalSize       Total size of the hardware error record variables.
+  @param[in, out] CommonVariableTotalSize      Total size of the other variables.
+  @param[in, out] CommonUserVariableTotalSize  Total size of the user variables.
+
+**/
+VOID
+AddVariableTotalSize (
+  IN     VARIABLE_HEADER        *Variable,
+  IN OUT UINTN                  *HwErrVariableTotalSize,
+  IN OUT UINTN                  *CommonVariableTotalSize,
+  IN OUT UINTN                  *CommonUserVariableTotalSize
+  )
+{
+  UINTN                         VariableSize;
+
+  if ((Variable->Attributes & EFI_VARIABLE_NON_VOLATILE) == 0) {
+    return;
+  }
+
+  VariableSize = (UINTN) GetNextVariablePtr (Variable) - (UINTN) Variable;
+  if ((Variable->Attributes & EFI_VARIABLE_HARDWARE_ERROR_RECORD) == EFI_VARIABLE_HARDWARE_ERROR_RECORD) {
+    *HwErrVariableTotalSize += VariableSize;
+  } else {
+    *CommonVariableTotalSize += VariableSize;
+    if (IsUserVariable (Variable)) {
+      *CommonUserVariableTotalSize += VariableSize;
+    }
+  }
+}
+
+/**
+  Walk the variables of mNvVariableCache for a reclaim step.
+
+  The walk stops once MaxSize bytes have been walked, or at the end of the
+  variables. The sizes of the variables that a reclaim would drop are added
+  to the totals.
+
+  @param[in]      Variable                     Pointer to the first variable.
+  @param[in]      MaxSize                      Number of bytes to walk.
+  @param[out]     KeptSize                     Size of the variables to keep.
+  @param[in, out] HwErrVariableTotalSize       Total size of the hardware error record variables.
+  @param[in, out] CommonVariableTotalSize      Total size of the other variables.
+  @param[in, out] CommonUserVariableTotalSize  Total size of the user variables.
+
+  @return Pointer to the variable the walk stopped at.
+
+**/
+VARIABLE_HEADER *
+WalkReclaimStepVariables (
+  IN     VARIABLE_HEADER        *Variable,
+  IN     UINTN                  MaxSize,
+  OUT    UINTN                  *KeptSize,
+  IN OUT UINTN                  *HwErrVariableTotalSize,
+  IN OUT UINTN                  *CommonVariableTotalSize,
+  IN OUT UINTN                  *CommonUserVariableTotalSize
+  )
+{
+  VARIABLE_HEADER               *StartVariable;
+  VARIABLE_HEADER               *NextVariable;
+
+  StartVariable = Variable;
+  *KeptSize     = 0;
+  while (IsValidVariableHeader (Variable, GetEndPointer (mNvVariableCache)) &&
+         ((UINTN) Variable - (UINTN) StartVariable < MaxSize)) {
+    NextVariable = GetNextVariablePtr (Variable);
+    if (IsReclaimableVariable (Variable)) {
+      AddVariableTotalSize (Variable, HwErrVariableTotalSize, CommonVariableTotalSize, CommonUserVariableTotalSize);
+    } else {
+      *KeptSize += (UINTN) NextVariable - (UINTN) Variable;
+    }
+    Variable = NextVariable;
+  }
+
+  return Variable;
+}
+
+/**
+  Copy the variables to keep of a range of mNvVariableCache to a buffer.
+
+  @param[in]  Variable          Pointer to the first variable of the range.
+  @param[in]  LastVariable      Pointer to the variable after the range.
+  @param[out] Buffer            Buffer of the size of the variables to keep.
+
+**/
+VOID
+CopyKeptVariables (
+  IN  VARIABLE_HEADER           *Variable,
+  IN  VARIABLE_HEADER           *LastVariable,
+  OUT UINT8                     *Buffer
+  )
+{
+  VARIABLE_HEADER               *NextVariable;
+  UINTN                         VariableSize;
+
+  while (Variable != LastVariable) {
+    NextVariable = GetNextVariablePtr (Variable);
+    if (!IsReclaimableVariable (Variable)) {
+      VariableSize = (UINTN) NextVariable - (UINTN) Variable;
+      CopyMem (Buffer, (UINT8 *) Variable, VariableSize);
+      Buffer += VariableSize;
+    }
+    Variable = NextVariable;
+  }
+}
+
+/**
+  Reclaim part of the non-volatile variable store.
+
+  A full Reclaim() rewrites the whole store in one FTW write, and the caller
+  stalls for as long as that takes. When PcdReclaimVariableSpaceThreshold and
+  PcdReclaimVariableSpaceStepSize are both set, this function is called after
+  each non-volatile SetVariable() at boot time instead. The first call of a boot
+  checks whether the variables Reclaim() would drop take more of the store than
+  the threshold allows. If they do, each call then does one FTW write of at
+  most about twice the step size, and walks about as much of the store, until
+  the dropped variables have been returned to the free space.
+
+  The dropped variables are gathered in a gap, a deleted variable with no
+  attributes, that moves towards the end of the store:
+  - While variables to keep follow the gap, up to the step size of them are
+    written at the start of the gap, followed by the new header of the gap.
+    Their old copies become data of the gap.
+  - Once the gap reaches the end of the store, it is cut into pieces of the
+    step size, one piece per step from its start on, and the pieces are then
+    erased from the last one back, one per step. The variables added behind
+    the gap in the meantime are moved to the start of the current piece at
+    each step, and so end up in front of the erased space. If they become
+    more than a step can move, the pass stops there.
+  Each step leaves a valid store in mNvVariableCache and writes it with one FTW
+  write. FTW makes the write complete or not happen across a power failure, so
+  the store is always the one before or after a step. No state is kept in the
+  store, the next boot checks the threshold again and starts a new pass.
+
+  @retval EFI_SUCCESS           The step is done, or there is nothing to reclaim.
+  @retval EFI_OUT_OF_RESOURCES  No enough memory resources.
+  @return Others                Unexpect error happened during FTW.
+
+**/
+EFI_STATUS
+ReclaimStep (
+  VOID
+  )
+{
+  VARIABLE_HEADER       *Variable;
+  VARIABLE_HEADER       *NextVariable;
+  VARIABLE_HEADER       *FirstVariable;
+  VARIABLE_HEADER       *LastVariable;
+  VARIABLE_HEADER       *EndPtr;
+  UINT8                 *PieceStart;
+  UINT8                 *ValidBuffer;
+  UINTN                 StepSize;
+  UINTN                 MinSize;
+  UINTN                 KeptSize;
+  UINTN                 ScannedSize;
+  UINTN                 NextOffset;
+  UINTN                 LastVariableOffset;
+  UINTN                 HwErrVariableTotalSize;
+  UINTN                 CommonVariableTotalSize;
+  UINTN                 CommonUserVariableTotalSize;
+  EFI_STATUS            Status;
+  STATIC BOOLEAN        Checked;
+
+  if (AtRuntime () || (mVariableModuleGlobal->FvbInstance == NULL) ||
+      (PcdGet32 (PcdReclaimVariableSpaceStepSize) == 0) ||
+      (PcdGet8 (PcdReclaimVariableSpaceThreshold) == 0)) {
+    return EFI_SUCCESS;
+  }
+
+  //
+  // Only the first call walks the whole store, to find whether there is
+  // enough to reclaim.
+  //
+  if (!Checked) {
+    Checked = TRUE;
+    if (GetReclaimableVariableSize () * 100 >= (UINTN) mNvVariableCache->Size * PcdGet8 (PcdReclaimVariableSpaceThreshold)) {
+      mVariableModuleGlobal->ReclaimStepOffset     = (UINTN) GetStartPointer (mNvVariableCache) - (UINTN) mNvVariableCache;
+      mVariableModuleGlobal->ReclaimStepTailOffset = 0;
+      mVariableModuleGlobal->ReclaimStepCount      = mVariableModuleGlobal->ReclaimCount;
+    }
+  }
+
+  //
+  // Nothing left to do, or Reclaim() has reclaimed the whole store since.
+  //
+  if ((mVariableModuleGlobal->ReclaimStepOffset == 0) ||
+      (mVariableModuleGlobal->ReclaimStepCount != mVariableModuleGlobal->ReclaimCount)) {
+    mVariableModuleGlobal->ReclaimStepOffset = 0;
+    return EFI_SUCCESS;
+  }
+
+  //
+  // The smallest deleted variable has an empty name and no data.
+  //
+  MinSize  = HEADER_ALIGN (GetVariableHeaderSize () + sizeof (CHAR16) + GET_PAD_SIZE (sizeof (CHAR16)));
+  StepSize = MAX (HEADER_ALIGN (PcdGet32 (PcdReclaimVariableSpaceStepSize)), MinSize);
+  EndPtr   = GetEndPointer (mNvVariableCache);
+  Variable = (VARIABLE_HEADER *) ((UINTN) mNvVariableCache + mVariableModuleGlobal->ReclaimStepOffset);
+  LastVariableOffset          = mVariableModuleGlobal->NonVolatileLastVariableOffset;
+  HwErrVariableTotalSize      = 0;
+  CommonVariableTotalSize     = 0;
+  CommonUserVariableTotalSize = 0;
+
+  if (mVariableModuleGlobal->ReclaimStepTailOffset == 0) {
+    //
+    // The variables before the first one to drop are already in place.
+    //
+    ScannedSize = 0;
+    while (IsValidVariableHeader (Variable, EndPtr) && !IsReclaimableVariable (Variable)) {
+      if (ScannedSize >= StepSize) {
+        mVariableModuleGlobal->ReclaimStepOffset = (UINTN) Variable - (UINTN) mNvVariableCache;
+        return EFI_SUCCESS;
+      }
+      NextVariable = GetNextVariablePtr (Variable);
+      ScannedSize += (UINTN) NextVariable - (UINTN) Variable;
+      Variable = NextVariable;
+    }
+    if (!IsValidVariableHeader (Variable, EndPtr)) {
+      mVariableModuleGlobal->ReclaimStepOffset = 0;
+      return EFI_SUCCESS;
+    }
+
+    //
+    // Take the step size of the variables behind the first one to drop, and
+    // move the ones to keep in front of all the dropped ones.
+    //
+    FirstVariable = Variable;
+    LastVariable  = WalkReclaimStepVariables (
+                      GetNextVariablePtr (FirstVariable),
+                      StepSize,
+                      &KeptSize,
+                      &HwErrVariableTotalSize,
+                      &CommonVariableTotalSize,
+                      &CommonUserVariableTotalSize
+                      );
+    NextOffset = (UINTN) FirstVariable - (UINTN) mNvVariableCache;
+    if (!IsValidVariableHeader (LastVariable, EndPtr)) {
+      mVariableModuleGlobal->ReclaimStepTailOffset = NextOffset + KeptSize;
+    }
+    AddVariableTotalSize (FirstVariable, &HwErrVariableTotalSize, &CommonVariableTotalSize, &CommonUserVariableTotalSize);
+
+    if (KeptSize != 0) {
+      ValidBuffer = AllocatePool (KeptSize);
+      if (ValidBuffer == NULL) {
+        mVariableModuleGlobal->ReclaimStepTailOffset = 0;
+        return EFI_OUT_OF_RESOURCES;
+      }
+      CopyKeptVariables (GetNextVariablePtr (FirstVariable), LastVariable, ValidBuffer);
+      CopyMem ((UINT8 *) FirstVariable, ValidBuffer, KeptSize);
+      FreePool (ValidBuffer);
+      NextOffset += KeptSize;
+    }
+    SetDeletedVariable (
+      (VARIABLE_HEADER *) ((UINTN) mNvVariableCache + NextOffset),
+      (UINTN) LastVariable - (UINTN) mNvVariableCache - NextOffset
+      );
+  } else {
+    //
+    // The gap is at the end of the store, and is cut into pieces of the step
+    // size from ReclaimStepTailOffset on. The piece at ReclaimStepOffset
+    // starts with the variables that earlier steps moved there, followed by
+    // its part of the gap, the only variable in it with no attributes.
+    //
+    PieceStart  = (UINT8 *) Variable;
+    while (IsValidVariableHeader (Variable, EndPtr) && (Variable->Attributes != 0) &&
+           ((UINTN) Variable - (UINTN) PieceStart < StepSize)) {
+      Variable = GetNextVariablePtr (Variable);
+    }
+    if (!IsValidVariableHeader (Variable, EndPtr) || (Variable->Attributes != 0) || !IsReclaimableVariable (Variable)) {
+      mVariableModuleGlobal->ReclaimStepOffset = 0;
+      return EFI_SUCCESS;
+    }
+    FirstVariable = Variable;
+
+    //
+    // Take the variables added behind the gap since, all of them, as they
+    // must end up in front of the erased space.
+    //
+    LastVariable = WalkReclaimStepVariables (
+                     GetNextVariablePtr (FirstVariable),
+                     StepSize,
+                     &KeptSize,
+                     &HwErrVariableTotalSize,
+                     &CommonVariableTotalSize,
+                     &CommonUserVariableTotalSize
+                     );
+    if (IsValidVariableHeader (LastVariable, EndPtr) ||
+        (((UINTN) GetNextVariablePtr (FirstVariable) > (UINTN) PieceStart + StepSize + MinSize) &&
+         ((UINTN) FirstVariable + KeptSize + MinSize > (UINTN) PieceStart + StepSize))) {
+      //
+      // Too many of them for a step, leave the rest to the next boot.
+      //
+      mVariableModuleGlobal->ReclaimStepOffset = 0;
+      return EFI_SUCCESS;
+    }
+    AddVariableTotalSize (FirstVariable, &HwErrVariableTotalSize, &CommonVariableTotalSize, &CommonUserVariableTotalSize);
+
+    ValidBuffer = NULL;
+    if (KeptSize != 0) {
+      ValidBuffer = AllocatePool (KeptSize);
+      if (ValidBuffer == NULL) {
+        return EFI_OUT_OF_RESOURCES;
+      }
+      CopyKeptVariables (GetNextVariablePtr (FirstVariable), LastVariable, ValidBuffer);
+    }
+
+    if ((UINTN) GetNextVariablePtr (FirstVariable) > (UINTN) PieceStart + StepSize + MinSize) {
+      //
+      // Cut the piece off the gap.
+      //
+      SetDeletedVariable (
+        (VARIABLE_HEADER *) (PieceStart + StepSize),
+        (UINTN) LastVariable - (UINTN) PieceStart - StepSize
+        );
+      if (ValidBuffer != NULL) {
+        CopyMem ((UINT8 *) FirstVariable, ValidBuffer, KeptSize);
+      }
+      SetDeletedVariable (
+        (VARIABLE_HEADER *) ((UINTN) FirstVariable + KeptSize),
+        (UINTN) PieceStart + StepSize - (UINTN) FirstVariable - KeptSize
+        );
+      NextOffset = mVariableModuleGlobal->ReclaimStepOffset + StepSize;
+    } else {
+      //
+      // Erase the last piece, the one before it is next.
+      //
+      if (ValidBuffer != NULL) {
+        CopyMem ((UINT8 *) FirstVariable, ValidBuffer, KeptSize);
+      }
+      SetMem ((UINT8 *) FirstVariable + KeptSize, (UINTN) LastVariable - (UINTN) FirstVariable - KeptSize, 0xff);
+      LastVariableOffset = (UINTN) FirstVariable + KeptSize - (UINTN) mNvVariableCache;
+      if (mVariableModuleGlobal->ReclaimStepOffset > mVariableModuleGlobal->ReclaimStepTailOffset) {
+        NextOffset = mVariableModuleGlobal->ReclaimStepOffset - StepSize;
+      } else {
+        NextOffset = 0;
+      }
+    }
+    if (ValidBuffer != NULL) {
+      FreePool (ValidBuffer);
+    }
+  }
+
+  //
+  // Only the variables from FirstVariable up to LastVariable have changed.
+  //
+  PERF_START (NULL, "ReclaimStep", "Variable", 0);
+  Status = FtwVariableSpaceRange (
+             mVariableModuleGlobal->VariableGlobal.NonVolatileVariableBase,
+             mNvVariableCache,
+             (UINTN) FirstVariable - (UINTN) mNvVariableCache,
+             (UINTN) LastVariable - (UINTN) FirstVariable
+             );
+  PERF_END (NULL, "ReclaimStep", "Variable", 0);
+
+  if (!EFI_ERROR (Status)) {
+    mVariableModuleGlobal->HwErrVariableTotalSize -= MIN (HwErrVariableTotalSize, mVariableModuleGlobal->HwErrVariableTotalSize);
+    mVariableModuleGlobal->CommonVariableTotalSize -= MIN (CommonVariableTotalSize, mVariableModuleGlobal->CommonVariableTotalSize);
+    mVariableModuleGlobal->CommonUserVariableTotalSize -= MIN (CommonUserVariableTotalSize, mVariableModuleGlobal->CommonUserVariableTotalSize);
+    mVariableModuleGlobal->NonVolatileLastVariableOffset = LastVariableOffset;
+    mVariableModuleGlobal->ReclaimStepOffset = NextOffset;
+  } else {
+    CopyMem (
+      mNvVariableCache,
+      (UINT8 *) (UINTN) mVariableModuleGlobal->VariableGlobal.NonVolatileVariableBase,
+      mNvVariableCache->Size
+      );
+    mVariableModuleGlobal->ReclaimStepOffset = 0;
+  }
+
+  ResetVariableIndex (mVariableModuleGlobal->NvIndex);
+  mVariableModuleGlobal->ReclaimCount++;
+  mVariableModuleGlobal->ReclaimStepCount = mVariableModuleGlobal->ReclaimCount;
+
+  return Status;
+}
+
+/**
+  This function reclaims variable storage if free size is below the threshold,
+  or if deleted variables take more of it than PcdReclaimVariableSpaceThreshold allows.
 
   Caution: This function may be invoked at SMM mode.
   Care must be taken to make sure not security issue.
@@ -3612,12 +4474,15 @@ ReclaimForOS(
   RemainingHwErrVariableSpace = PcdGet32 (PcdHwErrStorageSize) - mVariableModuleGlobal->HwErrVariableTotalSize;
 
   //
-  // Check if the free area is below a threshold.
+  // Check if the free area is below a threshold, or if the deleted variables are
+  // above one, so that the space is not reclaimed by a later SetVariable().
   //
   if (((RemainingCommonRuntimeVariableSpace < mVariableModuleGlobal->MaxVariableSize) ||
        (RemainingCommonRuntimeVariableSpace < mVariableModuleGlobal->MaxAuthVariableSize)) ||
       ((PcdGet32 (PcdHwErrStorageSize) != 0) &&
-       (RemainingHwErrVariableSpace < PcdGet32 (PcdMaxHardwareErrorVariableSize)))){
+       (RemainingHwErrVariableSpace < PcdGet32 (PcdMaxHardwareErrorVariableSize))) ||
+      ((PcdGet8 (PcdReclaimVariableSpaceThreshold) != 0) &&
+       (GetReclaimableVariableSize () * 100 >= (UINTN) mNvVariableCache->Size * PcdGet8 (PcdReclaimVariableSpaceThreshold)))){
     Status = Reclaim (
             mVariableModuleGlobal->VariableGlobal.NonVolatileVariableBase,
             &mVariableModuleGlobal->NonVolatileLastVariableOffset,
@@ -3812,7 +4677,10 @@ InitNonVolatileVariableStore (
     VariableSize = (UINTN) NextVariable - (UINTN) Variable;
     if ((Variable->Attributes & (EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_HARDWARE_ERROR_RECORD)) == (EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_HARDWARE_ERROR_RECORD)) {
       mVariableModuleGlobal->HwErrVariableTotalSize += VariableSize;
-    } else {
+    } else if ((Variable->Attributes & EFI_VARIABLE_NON_VOLATILE) != 0) {
+      //
+      // The deleted variables ReclaimStep() leaves have no attributes and are not counted.
+      //
       mVariableModuleGlobal->CommonVariableTotalSize += VariableSize;
     }
 
@@ -4136,6 +5004,12 @@ VariableCommonInitialize (
   VolatileVariableStore->Reserved    = 0;
   VolatileVariableStore->Reserved1   = 0;
 
+  //
+  // Without hash indexes the variable stores are just walked to find a variable.
+  //
+  mVariableModuleGlobal->VolatileIndex = CreateVariableIndex (VolatileVariableStore->Size);
+  mVariableModuleGlobal->NvIndex       = CreateVariableIndex (mNvVariableCache->Size);
+
   return EFI_SUCCESS;
 }
 
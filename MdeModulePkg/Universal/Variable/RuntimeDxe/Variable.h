@@ -37,6 +37,7 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include <Library/MemoryAllocationLib.h>
 #include <Library/AuthVariableLib.h>
 #include <Library/VarCheckLib.h>
+#include <Library/PerformanceLib.h>
 #include <Guid/GlobalVariable.h>
 #include <Guid/EventGroup.h>
 #include <Guid/VariableFormat.h>
@@ -78,6 +79,60 @@ typedef struct {
   BOOLEAN         Volatile;
 } VARIABLE_POINTER_TRACK;
 
+///
+/// Bytes of variable store per hash index entry. Variables beyond the
+/// capacity of the index are found by walking the store as before.
+///
+#define VARIABLE_INDEX_BYTES_PER_ENTRY  64
+
+typedef struct {
+  //
+  // Offset of the variable header from the variable store header.
+  //
+  UINT32          Offset;
+  //
+  // One-based number of the next entry in the same bucket, 0 ends the chain.
+  //
+  UINT32          Next;
+} VARIABLE_INDEX_ENTRY;
+
+///
+/// Hash index of the variables in a variable store, keyed by VendorGuid and name.
+/// It is followed by BucketCount bucket heads and MaxEntryCount entries, and only
+/// holds offsets so that it stays valid after SetVirtualAddressMap().
+///
+typedef struct {
+  //
+  // Offset of the first variable not yet indexed, 0 if nothing is indexed.
+  //
+  UINTN           IndexedOffset;
+  UINT32          BucketCount;
+  UINT32          EntryCount;
+  UINT32          MaxEntryCount;
+} VARIABLE_INDEX;
+
+#define VARIABLE_INDEX_BUCKETS(Index)  ((UINT32 *) ((Index) + 1))
+#define VARIABLE_INDEX_ENTRIES(Index)  ((VARIABLE_INDEX_ENTRY *) (VARIABLE_INDEX_BUCKETS (Index) + (Index)->BucketCount))
+
+///
+/// Number of variable enumerations that GetNextVariableName() can continue
+/// without looking up the variable returned last.
+///
+#define VARIABLE_NEXT_CURSOR_COUNT  4
+
+typedef struct {
+  //
+  // Store and offset of the variable returned last, Offset is 0 if unused.
+  // Offsets are used so that the cursor survives SetVirtualAddressMap().
+  //
+  VARIABLE_STORE_TYPE Type;
+  UINTN               Offset;
+  //
+  // Value of ReclaimCount when the variable was returned.
+  //
+  UINTN               ReclaimCount;
+} VARIABLE_NEXT_CURSOR;
+
 typedef struct {
   EFI_PHYSICAL_ADDRESS  HobVariableBase;
   EFI_PHYSICAL_ADDRESS  VolatileVariableBase;
@@ -106,6 +161,20 @@ typedef struct {
   CHAR8           *PlatformLang;
   CHAR8           Lang[ISO_639_2_ENTRY_SIZE + 1];
   EFI_FIRMWARE_VOLUME_BLOCK_PROTOCOL *FvbInstance;
+  VARIABLE_INDEX  *VolatileIndex;
+  VARIABLE_INDEX  *NvIndex;
+  UINTN           ReclaimCount;
+  UINTN           NextCursorIndex;
+  VARIABLE_NEXT_CURSOR NextCursor[VARIABLE_NEXT_CURSOR_COUNT];
+  //
+  // Offset of the variable the next ReclaimStep() starts at, 0 if there is
+  // nothing to reclaim, and offset of the gap at the end of the NV store that
+  // it is erasing, 0 if it has not got there. Only valid while
+  // ReclaimStepCount is equal to ReclaimCount.
+  //
+  UINTN           ReclaimStepOffset;
+  UINTN           ReclaimStepTailOffset;
+  UINTN           ReclaimStepCount;
 } VARIABLE_MODULE_GLOBAL;
 
 /**
@@ -142,6 +211,30 @@ FtwVariableSpace (
   IN VARIABLE_STORE_HEADER  *VariableBuffer
   );
 
+/**
+  Writes a range of a buffer to variable storage space, in the working block.
+
+  Same as FtwVariableSpace(), for a caller that knows the buffer only differs
+  from the variable storage space within the range.
+
+  @param  VariableBase   Base address of the variable to write.
+  @param  VariableBuffer Point to the variable data buffer.
+  @param  Offset         Offset of the range in the variable data buffer.
+  @param  Length         Length of the range.
+
+  @retval EFI_SUCCESS    The function completed successfully.
+  @retval EFI_NOT_FOUND  Fail to locate Fault Tolerant Write protocol.
+  @retval EFI_ABORTED    The function could not complete successfully.
+
+**/
+EFI_STATUS
+FtwVariableSpaceRange (
+  IN EFI_PHYSICAL_ADDRESS   VariableBase,
+  IN VARIABLE_STORE_HEADER  *VariableBuffer,
+  IN UINTN                  Offset,
+  IN UINTN                  Length
+  );
+
 /**
   Finds variable in storage blocks of volatile and non-volatile storage areas.
 
@@ -448,6 +541,20 @@ ReclaimForOS(
   VOID
   );
 
+/**
+  Reclaim part of the non-volatile variable store, with one FTW write of about
+  PcdReclaimVariableSpaceStepSize bytes of it.
+
+  @retval EFI_SUCCESS           The step is done, or there is nothing to reclaim.
+  @retval EFI_OUT_OF_RESOURCES  No enough memory resources.
+  @return Others                Unexpect error happened during FTW.
+
+**/
+EFI_STATUS
+ReclaimStep (
+  VOID
+  );
+
 /**
   Get non-volatile maximum variable size.
 
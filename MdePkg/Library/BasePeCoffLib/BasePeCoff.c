@@ -901,6 +901,67 @@ PeCoffLoaderImageAddress (
   return (CHAR8 *)((UINTN) ImageContext->ImageAddress + Address - TeStrippedOffset);
 }
 
+/**
+  Applies the DIR64, HIGHLOW and ABSOLUTE fixups at the start of a base
+  relocation block whose whole page lies within the image.
+
+  Every fixup of the block is within the page, so none of them needs the
+  bounds check of PeCoffLoaderImageAddress().  Runs of fixups of the same
+  type, which is how linkers emit them, are applied without decoding the
+  type again.
+
+  @param  FixupBase         The loaded address of the page of the block.
+  @param  Reloc             The first relocation entry to apply.
+  @param  RelocEnd          The end of the relocation entries of the block.
+  @param  Adjust            The delta to add to the fixups.
+
+  @return The first relocation entry of another type, or RelocEnd.
+
+**/
+UINT16 *
+PeCoffLoaderRelocateBlock (
+  IN     CHAR8                                 *FixupBase,
+  IN     UINT16                                *Reloc,
+  IN     UINT16                                *RelocEnd,
+  IN     UINT64                                Adjust
+  )
+{
+  UINT32                                Adjust32;
+  UINT32                                *Fixup32;
+  UINT64                                *Fixup64;
+
+  Adjust32 = (UINT32) Adjust;
+
+  while (Reloc < RelocEnd) {
+    switch ((*Reloc) >> 12) {
+    case EFI_IMAGE_REL_BASED_DIR64:
+      do {
+        Fixup64  = (UINT64 *) (FixupBase + (*Reloc & 0xFFF));
+        *Fixup64 = *Fixup64 + Adjust;
+        Reloc   += 1;
+      } while ((Reloc < RelocEnd) && (((*Reloc) >> 12) == EFI_IMAGE_REL_BASED_DIR64));
+      break;
+
+    case EFI_IMAGE_REL_BASED_HIGHLOW:
+      do {
+        Fixup32  = (UINT32 *) (FixupBase + (*Reloc & 0xFFF));
+        *Fixup32 = *Fixup32 + Adjust32;
+        Reloc   += 1;
+      } while ((Reloc < RelocEnd) && (((*Reloc) >> 12) == EFI_IMAGE_REL_BASED_HIGHLOW));
+      break;
+
+    case EFI_IMAGE_REL_BASED_ABSOLUTE:
+      Reloc += 1;
+      break;
+
+    default:
+      return Reloc;
+    }
+  }
+
+  return Reloc;
+}
+
 /**
   Applies relocation fixups to a PE/COFF image that was loaded with PeCoffLoaderLoadImage().
 
@@ -1088,6 +1149,15 @@ PeCoffLoaderRelocateImage (
         return RETURN_LOAD_ERROR;
       }  
 
+      //
+      // If the whole page of the block is within the image and no fixup data
+      // has to be logged, apply the common fixups without checking each of them
+      //
+      if ((FixupData == NULL) &&
+          ((UINT64) RelocBase->VirtualAddress + SIZE_4KB <= (UINT64) ImageContext->ImageSize + TeStrippedOffset)) {
+        Reloc = PeCoffLoaderRelocateBlock (FixupBase, Reloc, RelocEnd, Adjust);
+      }
+
       //
       // Run this relocation record
       //
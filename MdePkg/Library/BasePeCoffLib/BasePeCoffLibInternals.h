@@ -130,4 +130,24 @@ PeCoffLoaderImageAddress (
   IN     UINTN                                 TeStrippedOffset
   );
 
+/**
+  Applies the DIR64, HIGHLOW and ABSOLUTE fixups at the start of a base
+  relocation block whose whole page lies within the image.
+
+  @param  FixupBase         The loaded address of the page of the block.
+  @param  Reloc             The first relocation entry to apply.
+  @param  RelocEnd          The end of the relocation entries of the block.
+  @param  Adjust            The delta to add to the fixups.
+
+  @return The first relocation entry of another type, or RelocEnd.
+
+**/
+UINT16 *
+PeCoffLoaderRelocateBlock (
+  IN     CHAR8                                 *FixupBase,
+  IN     UINT16                                *Reloc,
+  IN     UINT16                                *RelocEnd,
+  IN     UINT64                                Adjust
+  );
+
 #endif